@@ -0,0 +1,329 @@
+#include "assets.hpp"
+
+namespace coffee
+{
+    /**
+     * @brief 열린 에셋 파일
+     * 
+     *        an opened asset file
+     */
+    struct asset_file {
+        const uint8_t* data;
+
+        uint32_t size;
+
+        uint32_t pos;
+    };
+
+    /**
+     * @brief 경로에 해당하는 에셋 항목을 찾습니다
+     * 
+     *        finds the asset entry of a path
+     */
+    static const asset_entry* find_asset(const char* path);
+
+    static bool init_lv_fs(char fs_letter);
+
+    /**
+     * @brief lv_fs에서 파일을 열 때 콜백됩니다
+     * 
+     *        called by lv_fs when opening a file
+     */
+    static void* open_file(lv_fs_drv_t* drv, const char* path, lv_fs_mode_t mode);
+
+    /**
+     * @brief lv_fs에서 파일을 닫을 때 콜백됩니다
+     * 
+     *        called by lv_fs when closing a file
+     */
+    static lv_fs_res_t close_file(lv_fs_drv_t* drv, void* file_p);
+
+    /**
+     * @brief lv_fs에서 파일을 읽을 때 콜백됩니다
+     * 
+     *        called by lv_fs when reading from a file
+     */
+    static lv_fs_res_t read_file(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br);
+
+    /**
+     * @brief lv_fs에서 파일 커서를 이동할 때 콜백됩니다
+     * 
+     *        called by lv_fs when seeking within a file
+     */
+    static lv_fs_res_t seek_file(lv_fs_drv_t* drv, void* file_p, uint32_t pos, lv_fs_whence_t whence);
+
+    /**
+     * @brief lv_fs에서 파일 커서의 위치를 확인할 때 콜백됩니다
+     * 
+     *        called by lv_fs when telling the current file position
+     */
+    static lv_fs_res_t tell_file(lv_fs_drv_t* drv, void* file_p, uint32_t* pos_p);
+
+    // 매핑된 에셋 이미지
+    // mapped asset image
+    static const uint8_t* image = nullptr;
+
+    static const asset_entry* entries = nullptr;
+
+    static uint32_t entry_count = 0;
+
+    static spi_flash_mmap_handle_t mmap_handle;
+
+    bool init_assets(char fs_letter)
+    {
+        const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, COFFEE_ASSETS_PARTITION);
+        if(!part) {
+            Serial.printf("warning: no asset partition(%s)\n", COFFEE_ASSETS_PARTITION);
+
+            return false;
+        }
+
+        asset_header header;
+
+        if(esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK || memcmp(header.magic, "CFAS", 4)
+           || header.size > part->size || header.size < sizeof(header) + (uint64_t) header.count * sizeof(asset_entry)) {
+            Serial.println("warning: asset partition does not hold an asset image, flash one built with tools/pack_assets.py");
+
+            return false;
+        }
+
+        // 이미지 크기만큼만 매핑하여 MMU 페이지를 아낌
+        // maps only as much as the image to save MMU pages
+        const void* ptr;
+
+        if(esp_partition_mmap(part, 0, header.size, SPI_FLASH_MMAP_DATA, &ptr, &mmap_handle) != ESP_OK) {
+            Serial.println("error: failed to map asset partition");
+
+            return false;
+        }
+
+        image = static_cast<const uint8_t*>(ptr);
+        entries = reinterpret_cast<const asset_entry*>(image + sizeof(asset_header));
+        entry_count = header.count;
+
+        for(uint32_t i = 0; i < entry_count; i++)
+            if(entries[i].offset > header.size || entries[i].size > header.size - entries[i].offset
+               || entries[i].name[COFFEE_ASSET_NAME_MAX - 1]) {
+                Serial.println("error: asset image is broken");
+
+                spi_flash_munmap(mmap_handle);
+
+                image = nullptr;
+                entries = nullptr;
+                entry_count = 0;
+
+                return false;
+            }
+
+        if(!init_lv_fs(fs_letter))
+            return false;
+
+#if COFFEE_LIST_FILES
+        list_assets();
+#endif
+
+        return true;
+    }
+
+    const uint8_t* asset_data(const char* path, uint32_t* size)
+    {
+        const asset_entry* entry = find_asset(path);
+        if(!entry)
+            return nullptr;
+
+        if(size)
+            *size = entry->size;
+
+        return image + entry->offset;
+    }
+
+    bool asset_img_dsc(const char* path, lv_img_dsc_t* dsc)
+    {
+        uint32_t size;
+
+        const uint8_t* data = asset_data(path, &size);
+        if(!data)
+            return false;
+
+        memset(dsc, 0, sizeof(*dsc));
+
+        size_t len = strlen(path);
+
+        if(len > 4 && !strcmp(path + len - 4, ".bin")) {
+            if(size < sizeof(lv_img_header_t))
+                return false;
+
+            memcpy(&dsc->header, data, sizeof(lv_img_header_t));
+
+            dsc->data = data + sizeof(lv_img_header_t);
+            dsc->data_size = size - sizeof(lv_img_header_t);
+        } else {
+            dsc->header.cf = LV_IMG_CF_RAW;
+
+            dsc->data = data;
+            dsc->data_size = size;
+        }
+
+        return true;
+    }
+
+    const uint8_t* asset_font_data(const char* path, uint32_t* size)
+    {
+        // TrueType, OpenType(CFF), 예전 Mac TrueType, 폰트 모음의 시작 표시
+        // start tags of TrueType, OpenType(CFF), old Mac TrueType and font collections
+        static const char tags[][4] = { { 0, 1, 0, 0 }, { 'O', 'T', 'T', 'O' }, { 't', 'r', 'u', 'e' }, { 't', 't', 'c', 'f' } };
+
+        uint32_t font_size;
+
+        const uint8_t* data = asset_data(path, &font_size);
+        if(!data || font_size < 4)
+            return nullptr;
+
+        for(const char* tag: tags)
+            if(!memcmp(data, tag, 4)) {
+                if(size)
+                    *size = font_size;
+
+                return data;
+            }
+
+        Serial.printf("error: not a TrueType / OpenType font(%s)\n", path);
+
+        return nullptr;
+    }
+
+    void list_assets(void)
+    {
+        Serial.printf("files in asset partition: %c:\n", COFFEE_ASSETS_LETTER);
+
+        for(uint32_t i = 0; i < entry_count; i++)
+            Serial.printf("    /%s(%uB)\n", entries[i].name, entries[i].size);
+    }
+
+    static const asset_entry* find_asset(const char* path)
+    {
+        if(!image || !path)
+            return nullptr;
+
+        while(*path == '/')
+            path++;
+
+        // 항목은 경로 순으로 정렬되어 있음
+        // entries are sorted by path
+        uint32_t lo = 0;
+        uint32_t hi = entry_count;
+
+        while(lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+
+            int cmp = strcmp(path, entries[mid].name);
+
+            if(!cmp)
+                return &entries[mid];
+            else if(cmp < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        return nullptr;
+    }
+
+    static bool init_lv_fs(char fs_letter)
+    {
+        // lvgl 파일 시스템 드라이버
+        // lvgl file system driver
+        static lv_fs_drv_t drv;
+
+        if(fs_letter < 'A' || fs_letter > 'Z') {
+            Serial.println("error: the file driver identification character must be an uppercase alphabet");
+
+            return false;
+        }
+
+        lv_fs_drv_init(&drv);
+
+        drv.letter = fs_letter;
+        drv.cache_size = 0;
+
+        drv.ready_cb = nullptr;
+
+        // 읽기 전용
+        // read-only
+        drv.open_cb = open_file;
+        drv.close_cb = close_file;
+        drv.read_cb = read_file;
+        drv.write_cb = nullptr;
+        drv.seek_cb = seek_file;
+        drv.tell_cb = tell_file;
+
+        lv_fs_drv_register(&drv);
+
+        return true;
+    }
+
+    static void* open_file(lv_fs_drv_t* drv, const char* path, lv_fs_mode_t mode)
+    {
+        if(mode & LV_FS_MODE_WR)
+            return nullptr;
+
+        const asset_entry* entry = find_asset(path);
+        if(!entry)
+            return nullptr;
+
+        return mem_new<asset_file>(MEM_ASSETS, asset_file { image + entry->offset, entry->size, 0 });
+    }
+
+    static lv_fs_res_t close_file(lv_fs_drv_t* drv, void* file_p)
+    {
+        mem_delete(static_cast<asset_file*>(file_p));
+
+        return LV_FS_RES_OK;
+    }
+
+    static lv_fs_res_t read_file(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br)
+    {
+        asset_file* file = static_cast<asset_file*>(file_p);
+        if(!file)
+            return LV_FS_RES_INV_PARAM;
+
+        *br = min(btr, file->size - file->pos);
+
+        memcpy(buf, file->data + file->pos, *br);
+        file->pos += *br;
+
+        return LV_FS_RES_OK;
+    }
+
+    static lv_fs_res_t seek_file(lv_fs_drv_t* drv, void* file_p, uint32_t pos, lv_fs_whence_t whence)
+    {
+        asset_file* file = static_cast<asset_file*>(file_p);
+        if(!file)
+            return LV_FS_RES_INV_PARAM;
+
+        if(whence == LV_FS_SEEK_SET)
+            file->pos = pos;
+        else if(whence == LV_FS_SEEK_CUR)
+            file->pos += pos;
+        else if(whence == LV_FS_SEEK_END)
+            file->pos = file->size + pos;
+        else
+            return LV_FS_RES_INV_PARAM;
+
+        if(file->pos > file->size)
+            file->pos = file->size;
+
+        return LV_FS_RES_OK;
+    }
+
+    static lv_fs_res_t tell_file(lv_fs_drv_t* drv, void* file_p, uint32_t* pos_p)
+    {
+        asset_file* file = static_cast<asset_file*>(file_p);
+        if(!file)
+            return LV_FS_RES_INV_PARAM;
+
+        *pos_p = file->pos;
+
+        return LV_FS_RES_OK;
+    }
+}
@@ -0,0 +1,165 @@
+#ifndef COFFEE_ASSETS_HPP
+#define COFFEE_ASSETS_HPP
+
+#include <string.h>
+
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+
+#include <Arduino.h>
+
+#include <lvgl.h>
+
+#include "def.h"
+#include "sd.hpp"
+
+/**
+ * @def COFFEE_ASSETS_PARTITION
+ * 
+ * @brief 에셋 이미지가 기록된 플래시 파티션의 이름입니다
+ * 
+ *        name of the flash partition holding the asset image
+ */
+#define COFFEE_ASSETS_PARTITION "assets"
+
+/**
+ * @def COFFEE_ASSETS_LETTER
+ * 
+ * @brief 에셋 파일 시스템의 lvgl 드라이버 식별 문자(대문자 알파벳)
+ * 
+ *        the drive letter(capitalized alphabet) used by lvgl to identify the asset file system
+ */
+#define COFFEE_ASSETS_LETTER 'F'
+
+/**
+ * @def COFFEE_ASSET_NAME_MAX
+ * 
+ * @brief 에셋 경로의 최대 길이(널 문자 포함)입니다, tools/pack_assets.py와 같아야 합니다
+ * 
+ *        maximum length of an asset path(including the null character), must match tools/pack_assets.py
+ */
+#define COFFEE_ASSET_NAME_MAX 56
+
+namespace coffee
+{
+    /**
+     * @brief 에셋 이미지 헤더
+     * 
+     *        헤더 뒤에는 경로 순으로 정렬된 count개의 asset_entry가, 그 뒤에는 4B 단위로 정렬된 파일 데이터가 이어집니다
+     * 
+     *        asset image header
+     * 
+     *        the header is followed by count asset_entry sorted by path, then by the file data aligned to 4B
+     */
+    struct asset_header {
+        char magic[4];
+
+        uint32_t count;
+
+        // 헤더를 포함한 이미지 전체 크기
+        // size of the whole image including the header
+        uint32_t size;
+
+        uint32_t reserved;
+    };
+
+    struct asset_entry {
+        // 앞의 '/'를 뺀 경로, 예: "icons/wifi.bin"
+        // path without the leading '/', e.g. "icons/wifi.bin"
+        char name[COFFEE_ASSET_NAME_MAX];
+
+        // 이미지 시작부터의 위치
+        // offset from the start of the image
+        uint32_t offset;
+
+        uint32_t size;
+    };
+
+    /**
+     * @brief 플래시 파티션의 에셋 이미지를 메모리에 매핑하고 lvgl 드라이브로 등록합니다
+     * 
+     *        maps the asset image in the flash partition into memory and registers it as a lvgl drive
+     * 
+     * @param fs_letter lvgl 드라이버 식별 문자(대문자 알파벳)
+     * 
+     *                  the drive letter(capitalized alphabet) used by lvgl to identify this file system
+     * 
+     * @return 에셋 파일 시스템 초기화 성공 여부
+     * 
+     *         asset file system initialization success
+     */
+    bool init_assets(char fs_letter);
+
+    /**
+     * @brief 매핑된 플래시 내 에셋 데이터의 위치를 가져옵니다, 복사 없이 디코더에 바로 넘길 수 있습니다
+     * 
+     *        gets the location of asset data in mapped flash, it can be passed straight to decoders without copying
+     * 
+     * @param path 에셋 경로(예: "/icons/wifi.bin")
+     * 
+     *             asset path(e.g. "/icons/wifi.bin")
+     * 
+     * @param size 에셋 크기가 저장될 변수, 필요 없다면 nullptr
+     * 
+     *             variable to store the asset size, nullptr if not needed
+     * 
+     * @return 에셋 데이터, 없다면 nullptr
+     * 
+     *         asset data, nullptr if there is none
+     */
+    const uint8_t* asset_data(const char* path, uint32_t* size = nullptr);
+
+    /**
+     * @brief 에셋을 가리키는 lvgl 이미지 설명자를 만듭니다, lv_img_set_src()에 넘기면 플래시에서 바로 그려집니다
+     * 
+     *        ".bin"으로 끝나는 에셋은 lvgl 이미지 변환기의 바이너리 형식으로, 그 외(PNG, JPG 등)는 해당 디코더가 처리하도록 LV_IMG_CF_RAW로 다룹니다
+     * 
+     *        makes a lvgl image descriptor pointing at an asset, passing it to lv_img_set_src() draws straight from flash
+     * 
+     *        assets ending in ".bin" are treated as the binary format of the lvgl image converter, others(PNG, JPG, ...) as LV_IMG_CF_RAW for their decoder
+     * 
+     * @param path 에셋 경로
+     * 
+     *             asset path
+     * 
+     * @param dsc 이미지 설명자가 저장될 구조체, 이미지를 사용하는 동안 유지되어야 합니다
+     * 
+     *            structure to store the image descriptor, must outlive the use of the image
+     * 
+     * @return 설명자 생성 성공 여부
+     * 
+     *         descriptor creation success
+     */
+    bool asset_img_dsc(const char* path, lv_img_dsc_t* dsc);
+
+    /**
+     * @brief 매핑된 플래시 내 TrueType / OpenType 폰트 에셋의 위치를 가져옵니다
+     * 
+     *        FreeType(lv_ft_info_t의 mem, mem_size) 등 메모리에서 폰트를 읽는 렌더러에 복사 없이 넘길 수 있습니다, lv_font_conv의 바이너리 폰트는 lv_font_load()가 RAM으로 풀어 읽으므로 에셋 드라이브 경로로 불러오세요
+     * 
+     *        gets the location of a TrueType / OpenType font asset in mapped flash
+     * 
+     *        it can be passed without copying to renderers reading fonts from memory such as FreeType(mem, mem_size of lv_ft_info_t), binary fonts from lv_font_conv are unpacked into RAM by lv_font_load(), so load them through an asset drive path
+     * 
+     * @param path 에셋 경로(예: "/fonts/nanum.ttf")
+     * 
+     *             asset path(e.g. "/fonts/nanum.ttf")
+     * 
+     * @param size 폰트 크기가 저장될 변수, 필요 없다면 nullptr
+     * 
+     *             variable to store the font size, nullptr if not needed
+     * 
+     * @return 폰트 데이터, 없거나 TrueType / OpenType 폰트가 아니라면 nullptr
+     * 
+     *         font data, nullptr if there is none or it is not a TrueType / OpenType font
+     */
+    const uint8_t* asset_font_data(const char* path, uint32_t* size = nullptr);
+
+    /**
+     * @brief 에셋 이미지 내의 모든 파일을 표시합니다
+     * 
+     *        lists all files in the asset image
+     */
+    void list_assets(void);
+}
+#endif
@@ -0,0 +1,15 @@
+#include "board.hpp"
+
+namespace coffee
+{
+    // C++17 이전에는 ODR 사용되는 constexpr 정적 멤버 배열에 클래스 밖 정의가 필요함
+    // before C++17, odr-used constexpr static member arrays need an out-of-class definition
+    constexpr int8_t crowpanel_7_0::pin_d[16];
+    constexpr panel_timing crowpanel_7_0::timings[TIMING_PROFILES];
+
+    constexpr int8_t crowpanel_5_0::pin_d[16];
+    constexpr panel_timing crowpanel_5_0::timings[TIMING_PROFILES];
+
+    constexpr int8_t crowpanel_4_3::pin_d[16];
+    constexpr panel_timing crowpanel_4_3::timings[TIMING_PROFILES];
+}
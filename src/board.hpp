@@ -0,0 +1,260 @@
+#ifndef COFFEE_BOARD_HPP
+#define COFFEE_BOARD_HPP
+
+#include <stdint.h>
+
+/**
+ * @def COFFEE_BOARD
+ * 
+ * @brief 드라이버가 대상으로 하는 보드입니다
+ * 
+ *        프로젝트를 빌드할 때 idf.py -DCOFFEE_BOARD=crowpanel_5_0 build와 같이 바꿀 수 있습니다
+ * 
+ *        board targeted by the driver
+ * 
+ *        can be changed when building the project, e.g. idf.py -DCOFFEE_BOARD=crowpanel_5_0 build
+ */
+#ifndef COFFEE_BOARD
+#define COFFEE_BOARD crowpanel_7_0
+#endif
+
+namespace coffee
+{
+    /**
+     * @brief RGB 패널 타이밍
+     * 
+     *        RGB panel timing
+     */
+    struct panel_timing {
+        const char* name;
+
+        uint32_t freq_write;
+
+        uint16_t hsync_front_porch;
+
+        uint16_t hsync_pulse_width;
+
+        uint16_t hsync_back_porch;
+
+        uint16_t vsync_front_porch;
+
+        uint16_t vsync_pulse_width;
+
+        uint16_t vsync_back_porch;
+    };
+
+    enum timing_profile {
+        TIMING_LOW,
+        TIMING_DEFAULT,
+        TIMING_FAST,
+        TIMING_PROFILES
+    };
+
+    enum touch_controller {
+        TOUCH_NONE,
+        TOUCH_GT911
+    };
+
+    /**
+     * @brief 터치 좌표의 회전, TAMC_GT911의 ROTATION_* 값과 같은 순서입니다
+     * 
+     *        rotation of the touch coordinates, in the same order as the ROTATION_* values of TAMC_GT911
+     */
+    enum touch_orientation {
+        TOUCH_ROTATION_LEFT,
+        TOUCH_ROTATION_INVERTED,
+        TOUCH_ROTATION_RIGHT,
+        TOUCH_ROTATION_NORMAL
+    };
+
+    /**
+     * @brief Elecrow CrowPanel 7.0" (800x480, GT911, PCA9557)
+     */
+    struct crowpanel_7_0 {
+        static constexpr uint16_t width = 800;
+
+        static constexpr uint16_t height = 480;
+
+        // B0-4, G0-5, R0-4 순서의 RGB 데이터 핀
+        // RGB data pins in B0-4, G0-5, R0-4 order
+        static constexpr int8_t pin_d[16] = { 15, 7, 6, 5, 4, 9, 46, 3, 8, 16, 1, 14, 21, 47, 48, 45 };
+
+        static constexpr int8_t pin_henable = 41;
+
+        static constexpr int8_t pin_vsync = 40;
+
+        static constexpr int8_t pin_hsync = 39;
+
+        static constexpr int8_t pin_pclk = 0;
+
+        static constexpr int8_t pin_backlight = 2;
+
+        // 타이밍 프로파일별 패널 타이밍, 픽셀 클록이 낮은 순서
+        // panel timing of each timing profile, in order of increasing pixel clock
+        static constexpr panel_timing timings[TIMING_PROFILES] = {
+            { "low",     12000000, 40, 48, 40, 1, 31, 13 },
+            { "default", 15000000, 40, 48, 40, 1, 31, 13 },
+            { "fast",    18000000, 40, 48, 40, 1, 31, 13 }
+        };
+
+        // GT911 리셋에 사용되는 PCA9557 IO 확장 칩 유무
+        // whether the PCA9557 IO expander used to reset the GT911 is present
+        static constexpr bool has_io_expander = true;
+
+        static constexpr int8_t i2c_sda = 19;
+
+        static constexpr int8_t i2c_scl = 20;
+
+        static constexpr touch_controller touch = TOUCH_GT911;
+
+        static constexpr int8_t touch_int = 3;
+
+        static constexpr int8_t touch_rst = 4;
+
+        static constexpr touch_orientation touch_rotation = TOUCH_ROTATION_NORMAL;
+
+        // 터치 좌표를 화면 좌표로 옮기기 위한 범위
+        // ranges used to map touch coordinates to screen coordinates
+        static constexpr int16_t touch_map_x1 = 800;
+
+        static constexpr int16_t touch_map_x2 = 0;
+
+        static constexpr int16_t touch_map_y1 = 480;
+
+        static constexpr int16_t touch_map_y2 = 0;
+
+        static constexpr int8_t sd_cs = 10;
+
+        static constexpr int8_t sd_mosi = 11;
+
+        static constexpr int8_t sd_sck = 12;
+
+        static constexpr int8_t sd_miso = 13;
+    };
+
+    /**
+     * @brief Elecrow CrowPanel 5.0" (800x480, GT911)
+     */
+    struct crowpanel_5_0 {
+        static constexpr uint16_t width = 800;
+
+        static constexpr uint16_t height = 480;
+
+        static constexpr int8_t pin_d[16] = { 8, 3, 46, 9, 1, 5, 6, 7, 15, 16, 4, 45, 48, 47, 21, 14 };
+
+        static constexpr int8_t pin_henable = 40;
+
+        static constexpr int8_t pin_vsync = 41;
+
+        static constexpr int8_t pin_hsync = 39;
+
+        static constexpr int8_t pin_pclk = 0;
+
+        static constexpr int8_t pin_backlight = 2;
+
+        static constexpr panel_timing timings[TIMING_PROFILES] = {
+            { "low",     12000000, 8, 4, 43, 8, 4, 12 },
+            { "default", 15000000, 8, 4, 43, 8, 4, 12 },
+            { "fast",    18000000, 8, 4, 43, 8, 4, 12 }
+        };
+
+        static constexpr bool has_io_expander = false;
+
+        static constexpr int8_t i2c_sda = 19;
+
+        static constexpr int8_t i2c_scl = 20;
+
+        static constexpr touch_controller touch = TOUCH_GT911;
+
+        static constexpr int8_t touch_int = -1;
+
+        static constexpr int8_t touch_rst = -1;
+
+        static constexpr touch_orientation touch_rotation = TOUCH_ROTATION_NORMAL;
+
+        static constexpr int16_t touch_map_x1 = 800;
+
+        static constexpr int16_t touch_map_x2 = 0;
+
+        static constexpr int16_t touch_map_y1 = 480;
+
+        static constexpr int16_t touch_map_y2 = 0;
+
+        static constexpr int8_t sd_cs = 10;
+
+        static constexpr int8_t sd_mosi = 11;
+
+        static constexpr int8_t sd_sck = 12;
+
+        static constexpr int8_t sd_miso = 13;
+    };
+
+    /**
+     * @brief Elecrow CrowPanel 4.3" (480x272)
+     * 
+     *        이 보드의 저항막 터치(XPT2046)는 아직 지원되지 않습니다
+     * 
+     *        the resistive touch(XPT2046) of this board is not supported yet
+     */
+    struct crowpanel_4_3 {
+        static constexpr uint16_t width = 480;
+
+        static constexpr uint16_t height = 272;
+
+        static constexpr int8_t pin_d[16] = { 8, 3, 46, 9, 1, 5, 6, 7, 15, 16, 4, 45, 48, 47, 21, 14 };
+
+        static constexpr int8_t pin_henable = 40;
+
+        static constexpr int8_t pin_vsync = 41;
+
+        static constexpr int8_t pin_hsync = 39;
+
+        static constexpr int8_t pin_pclk = 42;
+
+        static constexpr int8_t pin_backlight = 2;
+
+        static constexpr panel_timing timings[TIMING_PROFILES] = {
+            { "low",     6000000,  8, 4, 43, 8, 4, 12 },
+            { "default", 8000000,  8, 4, 43, 8, 4, 12 },
+            { "fast",    10000000, 8, 4, 43, 8, 4, 12 }
+        };
+
+        static constexpr bool has_io_expander = false;
+
+        static constexpr int8_t i2c_sda = 19;
+
+        static constexpr int8_t i2c_scl = 20;
+
+        static constexpr touch_controller touch = TOUCH_NONE;
+
+        static constexpr int8_t touch_int = -1;
+
+        static constexpr int8_t touch_rst = -1;
+
+        static constexpr touch_orientation touch_rotation = TOUCH_ROTATION_NORMAL;
+
+        static constexpr int16_t touch_map_x1 = 480;
+
+        static constexpr int16_t touch_map_x2 = 0;
+
+        static constexpr int16_t touch_map_y1 = 272;
+
+        static constexpr int16_t touch_map_y2 = 0;
+
+        static constexpr int8_t sd_cs = 10;
+
+        static constexpr int8_t sd_mosi = 11;
+
+        static constexpr int8_t sd_sck = 12;
+
+        static constexpr int8_t sd_miso = 13;
+    };
+
+    /**
+     * @brief 드라이버가 대상으로 하는 보드의 설명
+     * 
+     *        description of the board targeted by the driver
+     */
+    using board = COFFEE_BOARD;
+}
+#endif
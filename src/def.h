@@ -1,6 +1,10 @@
 #ifndef COFFEE_DEF_H
 #define COFFEE_DEF_H
 
-#define COFFEE_WIDTH 800
-#define COFFEE_HEIGHT 480
+#include "board.hpp"
+
+// 이전 버전과의 호환을 위한 별칭입니다, 새 코드에서는 coffee::board의 값을 사용하세요
+// aliases kept for compatibility with older versions, new code should use the values in coffee::board
+#define COFFEE_WIDTH (coffee::board::width)
+#define COFFEE_HEIGHT (coffee::board::height)
 #endif
@@ -16,79 +16,80 @@ namespace coffee
      */
     static void flush_disp(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* image);
 
+    /**
+     * @brief vsync 핀에 인터럽트를 걸어 프레임 주기를 감시합니다
+     * 
+     *        watches the frame period by attaching an interrupt to the vsync pin
+     * 
+     * @return 감시 시작 성공 여부
+     * 
+     *         watch start success
+     */
+    static bool init_scan_monitor(void);
+
+    /**
+     * @brief 현재 타이밍에 맞춰 vsync 핀의 인터럽트와 언더런을 감시할 LCD의 DMA 채널을 설정합니다, 버스를 다시 초기화한 뒤에도 호출됩니다
+     * 
+     *        sets up the vsync pin interrupt and the LCD's DMA channel watched for underruns for the current timing, also called after reinitializing the bus
+     */
+    static void watch_vsync(void);
+
+    /**
+     * @brief LCD 주변장치에 연결된 GDMA 출력 채널을 찾습니다
+     * 
+     *        finds the GDMA output channel connected to the LCD peripheral
+     * 
+     * @return 채널 번호, 찾지 못하면 -1
+     * 
+     *         channel number, or -1 if not found
+     */
+    static int find_lcd_dma(void);
+
+    /**
+     * @brief vsync마다 호출되어 프레임 주기와 언더런을 기록합니다
+     * 
+     *        called on every vsync to record the frame period and underruns
+     */
+    static void IRAM_ATTR on_vsync(void* arg);
+
+    /**
+     * @brief 초기화 도중 실패했을 때 이미 만든 세마포어와 화면 버퍼를 해제하고 vsync 인터럽트를 뗍니다
+     * 
+     *        frees the semaphores and screen buffer already created and detaches the vsync interrupt when initialization fails midway
+     */
+    static void release_lcd(void);
+
     LCD lcd;
 
-    // 화면에 실제 그려질 픽셀 색 정보 배열
-    // the array of pixel color values to be drawn
-    static lv_color_t* pixels = nullptr;
+    static timing_profile current_timing = COFFEE_TIMING_PROFILE;
 
-    LCD::LCD(void)
-    {
-        {
-            // 패널 기본 정보 설정
-            // set panel preferences
-            auto cfg = _panel.config();
-            cfg.memory_width = COFFEE_WIDTH;
-            cfg.memory_height = COFFEE_HEIGHT;
-            cfg.panel_width = COFFEE_WIDTH;
-            cfg.panel_height = COFFEE_HEIGHT;
-            cfg.offset_x = 0;
-            cfg.offset_y = 0;
-            _panel.config(cfg);
-        }
-
-        {
-            // 버스 정보 설정
-            // set bus information
-            auto cfg = _bus.config();
-            cfg.panel = &_panel;
-
-            cfg.pin_d0 = GPIO_NUM_15;
-            cfg.pin_d1 = GPIO_NUM_7;
-            cfg.pin_d2 = GPIO_NUM_6;
-            cfg.pin_d3 = GPIO_NUM_5;
-            cfg.pin_d4 = GPIO_NUM_4;
-
-            cfg.pin_d5 = GPIO_NUM_9;
-            cfg.pin_d6 = GPIO_NUM_46;
-            cfg.pin_d7 = GPIO_NUM_3;
-            cfg.pin_d8 = GPIO_NUM_8;
-            cfg.pin_d9 = GPIO_NUM_16;
-            cfg.pin_d10 = GPIO_NUM_1;
-
-            cfg.pin_d11 = GPIO_NUM_14;
-            cfg.pin_d12 = GPIO_NUM_21;
-            cfg.pin_d13 = GPIO_NUM_47;
-            cfg.pin_d14 = GPIO_NUM_48;
-            cfg.pin_d15 = GPIO_NUM_45;
-
-            cfg.pin_henable = GPIO_NUM_41;
-            cfg.pin_vsync = GPIO_NUM_40;
-            cfg.pin_hsync = GPIO_NUM_39;
-            cfg.pin_pclk = GPIO_NUM_0;
-            cfg.freq_write = 15000000;
-
-            cfg.hsync_polarity    = 0;
-            cfg.hsync_front_porch = 40;
-            cfg.hsync_pulse_width = 48;
-            cfg.hsync_back_porch  = 40;
-            
-            cfg.vsync_polarity    = 0;
-            cfg.vsync_front_porch = 1;
-            cfg.vsync_pulse_width = 31;
-            cfg.vsync_back_porch  = 13;
+    // 패널이 동작을 시작한 뒤에는 타이밍을 바꿀 때 버스를 다시 초기화해야 함
+    // once the panel is running, switching the timing has to reinitialize the bus
+    static bool lcd_started = false;
 
-            cfg.pclk_active_neg = 1;
-            cfg.de_idle_high = 0;
-            cfg.pclk_idle_high = 0;
+    static bool scan_attached = false;
 
-            _bus.config(cfg);
-        }
-            
-        _panel.setBus(&_bus);
+    static scan_stats scan = {};
 
-        setPanel(&_panel);
-    }
+    static portMUX_TYPE scan_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    // 언더런을 감시할 LCD의 GDMA 출력 채널, 찾지 못하면 -1
+    // the LCD's GDMA output channel watched for underruns, -1 if not found
+    static int lcd_dma = -1;
+
+    // vsync마다 주어지는 세마포어
+    // semaphore given on every vsync
+    static SemaphoreHandle_t vsync_sem = nullptr;
+
+    // lvgl과 다른 태스크가 lcd에 동시에 접근하지 않도록 하는 뮤텍스
+    // mutex keeping lvgl and other tasks from accessing lcd at the same time
+    static SemaphoreHandle_t lcd_mutex = nullptr;
+
+    static flush_hook_t flush_hook = nullptr;
+
+    // 화면에 실제 그려질 픽셀 색 정보 배열
+    // the array of pixel color values to be drawn
+    static lv_color_t* pixels = nullptr;
 
     bool init_IO(void)
     {
@@ -96,6 +97,9 @@ namespace coffee
         // chip for IO expansion
         static PCA9557 pca9557;
 
+        if(!board::has_io_expander)
+            return true;
+
         // ESP32-S3의 Direction(output-only) IO 핀(IO38) 초기화
         // initializes Direction(output-only) IO pin(IO38) of ESP32-S3
         pinMode(38, OUTPUT);
@@ -103,12 +107,20 @@ namespace coffee
         
         // PCA9557 설정
         // configurates PCA9557
-        if(!Wire.begin(19, 20)) {
+        if(!i2c.begin()) {
             Serial.println("error: failed to initialize IO pins");
             
             return false;
         }
 
+        // PCA9557 라이브러리는 Wire를 직접 사용하므로 설정이 끝날 때까지 버스를 점유
+        // the PCA9557 library uses Wire directly, so hold the bus until configuration is done
+        if(!i2c.lock()) {
+            Serial.println("error: failed to acquire I2C bus");
+
+            return false;
+        }
+
         pca9557.reset();
         pca9557.setMode(IO_OUTPUT);
 
@@ -120,6 +132,8 @@ namespace coffee
         delay(100);
         pca9557.setMode(IO1, IO_INPUT);
 
+        i2c.unlock();
+
         return true;
     }
 
@@ -133,6 +147,10 @@ namespace coffee
         // data buffer to be drawn to the screen
         static lv_disp_draw_buf_t draw_buf;
 
+        timing_budget budget;
+        if(!check_timing(timings[current_timing], &budget))
+            Serial.printf("warning: timing profile %s exceeds the PSRAM bandwidth budget(%u%% > %d%%)\n", timings[current_timing].name, budget.load_pct, COFFEE_PSRAM_BW_BUDGET);
+
         if(!lcd.begin()) {
             Serial.println("error: failed to initialize LCD driver");
 
@@ -140,19 +158,43 @@ namespace coffee
         }
         delay(100);
 
+        lcd_started = true;
+
         lcd.setTextSize(3);
 
-        uint32_t pixel_size = COFFEE_WIDTH * COFFEE_HEIGHT / COFFEE_DISP_BUF_BLOCKS;
+        lcd_mutex = xSemaphoreCreateMutex();
+        vsync_sem = xSemaphoreCreateBinary();
+        if(!lcd_mutex || !vsync_sem) {
+            Serial.println("error: failed to create LCD semaphores");
+
+            release_lcd();
+
+            return false;
+        }
+
+        // 화면 주사 감시는 통계를 위한 것이므로 실패해도 계속 진행
+        // the scanout monitor only provides statistics, so carry on if it fails
+        init_scan_monitor();
+
+        uint32_t pixel_size = disp_buf_size / sizeof(lv_color_t);
 
         // 화면 버퍼는 내부 메모리 상 DMA 영역에 할당
         // the screen buffer is allocated in a DMA area on internal memory
-        pixels = (lv_color_t*) heap_caps_malloc(sizeof(lv_color_t) * pixel_size, MALLOC_CAP_DMA);
+        pixels = (lv_color_t*) mem_alloc(disp_buf_size, MALLOC_CAP_DMA, MEM_DISPLAY);
         if(!pixels) {
             Serial.println("error: failed to allocate display buffer");
+
+            release_lcd();
             
             return false;
         }
-        
+
+        if(!init_lv_mem()) {
+            release_lcd();
+
+            return false;
+        }
+
         lv_init();
 
         lv_disp_draw_buf_init(&draw_buf, pixels, NULL, pixel_size);
@@ -166,16 +208,293 @@ namespace coffee
         
         lv_disp_drv_register(&disp_drv);
 
+#if COFFEE_LATENCY_TRACE
+        latency_attach(lv_disp_get_default());
+#endif
+
         turn_on_bl();
 
         return true;
     }
 
+    bool check_timing(const panel_timing& timing, timing_budget* budget)
+    {
+        uint32_t h_total = board::width + timing.hsync_front_porch + timing.hsync_pulse_width + timing.hsync_back_porch;
+        uint32_t v_total = board::height + timing.vsync_front_porch + timing.vsync_pulse_width + timing.vsync_back_porch;
+
+        uint64_t frame_clocks = (uint64_t) h_total * v_total;
+        uint64_t frame_bytes = (uint64_t) board::width * board::height * 2;
+
+        budget->refresh_centihz = (uint64_t) timing.freq_write * 100 / frame_clocks;
+        budget->frame_period_us = frame_clocks * 1000000 / timing.freq_write;
+
+        budget->scan_bw = timing.freq_write * 2;
+        budget->render_bw = frame_bytes * COFFEE_PSRAM_RENDER_PCT / 100 * timing.freq_write / frame_clocks;
+        budget->sd_bw = COFFEE_PSRAM_SD_BW;
+
+        // 옥탈 PSRAM은 클록의 양쪽 에지마다 8비트를 전송
+        // octal PSRAM transfers 8 bits on both clock edges
+        budget->psram_bw = COFFEE_PSRAM_CLK * 2;
+
+        budget->load_pct = ((uint64_t) budget->scan_bw + budget->render_bw + budget->sd_bw) * 100 / budget->psram_bw;
+        budget->fits = budget->load_pct <= COFFEE_PSRAM_BW_BUDGET;
+
+        return budget->fits;
+    }
+
+    bool set_timing(timing_profile profile)
+    {
+        if(profile < 0 || profile >= TIMING_PROFILES)
+            return false;
+
+        const panel_timing& timing = timings[profile];
+
+        timing_budget budget;
+        if(!check_timing(timing, &budget)) {
+            Serial.printf("error: timing profile %s exceeds the PSRAM bandwidth budget(%u%% > %d%%)\n", timing.name, budget.load_pct, COFFEE_PSRAM_BW_BUDGET);
+
+            return false;
+        }
+
+        auto cfg = lcd._bus.config();
+        auto prev_cfg = cfg;
+
+        apply_timing(cfg, timing);
+
+        if(!lcd_started) {
+            lcd._bus.config(cfg);
+
+            current_timing = profile;
+
+            return true;
+        }
+
+        // lvgl과 다른 태스크가 내보내는 중이 아닐 때, 프레임 버퍼는 패널이 가지고 있으므로 버스만 다시 초기화
+        // while neither lvgl nor other tasks are flushing, only the bus is reinitialized as the frame buffer belongs to the panel
+        if(!lock_lcd()) {
+            Serial.println("error: LCD is not initialized");
+
+            return false;
+        }
+
+        lcd.waitDMA();
+
+        if(scan_attached)
+            gpio_intr_disable((gpio_num_t) board::pin_vsync);
+
+        lcd._bus.release();
+        lcd._bus.config(cfg);
+
+        bool ok = lcd._bus.init();
+        if(ok)
+            current_timing = profile;
+        else {
+            Serial.printf("error: failed to apply timing profile %s\n", timing.name);
+
+            lcd._bus.release();
+            lcd._bus.config(prev_cfg);
+            lcd._bus.init();
+        }
+
+        if(scan_attached)
+            watch_vsync();
+
+        unlock_lcd();
+
+        return ok;
+    }
+
+    timing_profile get_timing(void)
+    {
+        return current_timing;
+    }
+
+    bool wait_vsync(uint32_t timeout_ms)
+    {
+        // 이전 vsync가 남겨둔 신호를 버리고 다음 vsync를 기다림
+        // drop a signal left over by an earlier vsync and wait for the next one
+        xSemaphoreTake(vsync_sem, 0);
+
+        return xSemaphoreTake(vsync_sem, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+    }
+
+    bool lock_lcd(TickType_t ticks)
+    {
+        return lcd_mutex && xSemaphoreTake(lcd_mutex, ticks) == pdTRUE;
+    }
+
+    void unlock_lcd(void)
+    {
+        xSemaphoreGive(lcd_mutex);
+    }
+
+    void set_flush_hook(flush_hook_t hook)
+    {
+        flush_hook = hook;
+    }
+
+    void get_scan_stats(scan_stats* stats)
+    {
+        portENTER_CRITICAL(&scan_lock);
+
+        *stats = scan;
+
+        portEXIT_CRITICAL(&scan_lock);
+    }
+
+    void reset_scan_stats(void)
+    {
+        portENTER_CRITICAL(&scan_lock);
+
+        scan.frames = 0;
+        scan.underruns = 0;
+        scan.last_period_us = 0;
+        scan.last_vsync_us = 0;
+
+        portEXIT_CRITICAL(&scan_lock);
+    }
+
+    void apply_timing(lgfx::Bus_RGB::config_t& cfg, const panel_timing& timing)
+    {
+        cfg.freq_write = timing.freq_write;
+
+        cfg.hsync_front_porch = timing.hsync_front_porch;
+        cfg.hsync_pulse_width = timing.hsync_pulse_width;
+        cfg.hsync_back_porch  = timing.hsync_back_porch;
+
+        cfg.vsync_front_porch = timing.vsync_front_porch;
+        cfg.vsync_pulse_width = timing.vsync_pulse_width;
+        cfg.vsync_back_porch  = timing.vsync_back_porch;
+    }
+
+    static bool init_scan_monitor(void)
+    {
+        // Arduino의 attachInterrupt()가 이미 ISR 서비스를 설치했을 수 있음
+        // Arduino's attachInterrupt() may have installed the ISR service already
+        esp_err_t err = gpio_install_isr_service(0);
+        if((err != ESP_OK && err != ESP_ERR_INVALID_STATE) || gpio_isr_handler_add((gpio_num_t) board::pin_vsync, on_vsync, nullptr) != ESP_OK) {
+            Serial.println("error: failed to attach vsync interrupt, scanout statistics are unavailable");
+
+            return false;
+        }
+
+        scan_attached = true;
+
+        watch_vsync();
+
+        if(lcd_dma < 0)
+            Serial.println("warning: LCD DMA channel not found, underruns are not counted");
+
+        return true;
+    }
+
+    static void watch_vsync(void)
+    {
+        gpio_num_t vsync = (gpio_num_t) board::pin_vsync;
+
+        timing_budget budget;
+        check_timing(timings[current_timing], &budget);
+
+        // 버스를 다시 초기화하면 다른 채널이 할당될 수 있음
+        // reinitializing the bus may allocate a different channel
+        int dma = find_lcd_dma();
+
+        // 감시를 시작하기 전의 언더런은 세지 않음
+        // underruns from before watching are not counted
+        if(dma >= 0)
+            GDMA.channel[dma].out.int_clr.val = GDMA_OUTFIFO_UDF_L1_CH0_INT_RAW | GDMA_OUTFIFO_UDF_L3_CH0_INT_RAW;
+
+        portENTER_CRITICAL(&scan_lock);
+
+        scan.expected_period_us = budget.frame_period_us;
+        scan.last_vsync_us = 0;
+
+        lcd_dma = dma;
+
+        portEXIT_CRITICAL(&scan_lock);
+
+        // LCD 주변장치의 출력은 그대로 두고 입력만 추가로 켜서 vsync 신호를 읽음
+        // keep the LCD peripheral driving the pin and additionally enable its input to read the vsync signal
+        gpio_input_enable(vsync);
+        gpio_set_intr_type(vsync, GPIO_INTR_NEGEDGE);
+
+        gpio_intr_enable(vsync);
+    }
+
+    static int find_lcd_dma(void)
+    {
+        for(int ch = 0; ch < SOC_GDMA_PAIRS_PER_GROUP; ch++)
+            if(GDMA.channel[ch].out.peri_sel.sel == SOC_GDMA_TRIG_PERIPH_LCD0)
+                return ch;
+
+        return -1;
+    }
+
+    static void IRAM_ATTR on_vsync(void* arg)
+    {
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL_ISR(&scan_lock);
+
+        if(scan.last_vsync_us)
+            scan.last_period_us = now - scan.last_vsync_us;
+
+        // vsync 주기는 픽셀 클록으로 정해져 언더런이 일어나도 바뀌지 않으므로, LCD가 빈 FIFO에서 픽셀을 가져갔는지를 DMA 채널의 인터럽트 상태로 확인
+        // the vsync period is set by the pixel clock and does not change on an underrun, so the interrupt status of the DMA channel tells whether the LCD pulled pixels from an empty FIFO
+        if(lcd_dma >= 0) {
+            uint32_t underflow = GDMA.channel[lcd_dma].out.int_raw.val & (GDMA_OUTFIFO_UDF_L1_CH0_INT_RAW | GDMA_OUTFIFO_UDF_L3_CH0_INT_RAW);
+
+            if(underflow) {
+                GDMA.channel[lcd_dma].out.int_clr.val = underflow;
+
+                scan.underruns++;
+            }
+        }
+
+        scan.frames++;
+        scan.last_vsync_us = now;
+
+        portEXIT_CRITICAL_ISR(&scan_lock);
+
+#if COFFEE_LATENCY_TRACE
+        latency_vsync(now, scan.expected_period_us);
+#endif
+
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(vsync_sem, &woken);
+
+        if(woken)
+            portYIELD_FROM_ISR();
+    }
+
+    static void release_lcd(void)
+    {
+        if(scan_attached) {
+            gpio_intr_disable((gpio_num_t) board::pin_vsync);
+            gpio_isr_handler_remove((gpio_num_t) board::pin_vsync);
+
+            scan_attached = false;
+        }
+
+        mem_free(pixels);
+        pixels = nullptr;
+
+        if(vsync_sem) {
+            vSemaphoreDelete(vsync_sem);
+            vsync_sem = nullptr;
+        }
+
+        if(lcd_mutex) {
+            vSemaphoreDelete(lcd_mutex);
+            lcd_mutex = nullptr;
+        }
+    }
+
     static void turn_on_bl(void)
     {
         ledcSetup(1, 300, 8);
 
-        ledcAttachPin(COFFEE_BACKLIGHT, 1);
+        ledcAttachPin(board::pin_backlight, 1);
         
         ledcWrite(1, 0);
         delay(500);
@@ -190,8 +509,27 @@ namespace coffee
         int32_t img_w = area->x2 - area->x1 + 1;
         int32_t img_h = area->y2 - area->y1 + 1;
 
+        lock_lcd();
+
+#if COFFEE_LATENCY_TRACE
+        bool traced = latency_flush_start(area);
+#endif
+
         lcd.pushImageDMA(area->x1, area->y1, img_w, img_h, (lgfx::rgb565_t*) &pixels->full);
 
+#if COFFEE_LATENCY_TRACE
+        if(traced) {
+            lcd.waitDMA();
+
+            latency_flush_done();
+        }
+#endif
+
+        if(flush_hook)
+            flush_hook(area);
+
+        unlock_lcd();
+
         lv_disp_flush_ready(disp_drv);
     }
 }
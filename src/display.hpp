@@ -1,8 +1,17 @@
 #ifndef COFFEE_DISPLAY_HPP
 #define COFFEE_DISPLAY_HPP
 
+#include <driver/gpio.h>
 #include <driver/i2c.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <soc/gdma_channel.h>
+#include <soc/gdma_reg.h>
+#include <soc/gdma_struct.h>
+#include <soc/soc_caps.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -17,6 +26,10 @@
 #include <PCA9557.h>
 
 #include "def.h"
+#include "i2c.hpp"
+#include "latency.hpp"
+#include "lv_alloc.h"
+#include "mem.hpp"
 
 /**
  * @def COFFEE_DISP_BUF_BLOCKS
@@ -35,8 +48,6 @@
  */
 #define COFFEE_DISP_BUF_BLOCKS 8
 
-#define COFFEE_BACKLIGHT 2
-
 /**
  * @def COFFEE_BRIGHTNESS
  * 
@@ -46,18 +57,235 @@
  */
 #define COFFEE_BRIGHTNESS 255
 
+/**
+ * @def COFFEE_TIMING_PROFILE
+ * 
+ * @brief 초기화 시 사용할 패널 타이밍 프로파일입니다
+ * 
+ *        화면이 흔들리거나 깜빡거리면 TIMING_LOW로, 더 높은 주사율이 필요하면 TIMING_FAST로 바꾸세요
+ * 
+ *        panel timing profile used at initialization
+ * 
+ *        change it to TIMING_LOW if the screen shakes or flickers, or to TIMING_FAST if a higher refresh rate is needed
+ */
+#define COFFEE_TIMING_PROFILE TIMING_DEFAULT
+
+/**
+ * @def COFFEE_PSRAM_CLK
+ * 
+ * @brief PSRAM 클록입니다(sdkconfig의 CONFIG_SPIRAM_SPEED_80M과 같아야 합니다)
+ * 
+ *        PSRAM clock(must match CONFIG_SPIRAM_SPEED_80M in sdkconfig)
+ */
+#define COFFEE_PSRAM_CLK 80000000
+
+/**
+ * @def COFFEE_PSRAM_BW_BUDGET
+ * 
+ * @brief 옥탈 PSRAM 이론 대역폭 중 화면 주사, 렌더링, SD 카드 스트리밍에 쓸 수 있는 비율입니다(%)
+ * 
+ *        나머지는 명령 및 지연 오버헤드와 CPU 캐시 미스로 사라지는 몫입니다
+ * 
+ *        share of the theoretical octal PSRAM bandwidth the scanout, rendering and SD card streaming may use together(%)
+ * 
+ *        the rest is lost to command and latency overhead and to CPU cache misses
+ */
+#define COFFEE_PSRAM_BW_BUDGET 50
+
+/**
+ * @def COFFEE_PSRAM_RENDER_PCT
+ * 
+ * @brief 렌더링을 위해 남겨둘 대역폭으로, 매 프레임 다시 그려 프레임 버퍼에 옮기는 화면의 비율입니다(%)
+ * 
+ *        화면의 일부만 바뀌는 응용 프로그램이라면 이 값을 줄여 더 빠른 프로파일을 쓸 수 있습니다
+ * 
+ *        bandwidth left for rendering, as the share of the screen redrawn and moved into the frame buffer on every frame(%)
+ * 
+ *        applications changing only part of the screen can lower this value to allow faster profiles
+ */
+#define COFFEE_PSRAM_RENDER_PCT 100
+
+/**
+ * @def COFFEE_PSRAM_SD_BW
+ * 
+ * @brief SD 카드 스트리밍을 위해 남겨둘 PSRAM 대역폭입니다(B/s)
+ * 
+ *        기본값은 80MHz SPI로 읽은 10MB/s를 PSRAM에 쓰고 디코딩하며 다시 읽는 양이며, SD 카드에서 스트리밍하지 않는다면 0으로 두세요
+ * 
+ *        PSRAM bandwidth left for SD card streaming(B/s)
+ * 
+ *        the default is 10MB/s read over 80MHz SPI, written to PSRAM and read back while decoding, set it to 0 when not streaming from the SD card
+ */
+#define COFFEE_PSRAM_SD_BW (20 * 1000 * 1000)
+
 namespace coffee
 {
-    class LCD: public lgfx::LGFX_Device
+    /**
+     * @brief 타이밍 프로파일별 패널 타이밍, 픽셀 클록이 낮은 순서입니다
+     * 
+     *        panel timing of each timing profile, in order of increasing pixel clock
+     */
+    constexpr const panel_timing (&timings)[TIMING_PROFILES] = board::timings;
+
+    /**
+     * @brief init_lcd()가 내부 DMA 메모리에 할당하는 화면 버퍼의 크기입니다
+     * 
+     *        size of the screen buffer init_lcd() allocates in internal DMA memory
+     */
+    constexpr size_t disp_buf_size = sizeof(lv_color_t) * board::width * board::height / COFFEE_DISP_BUF_BLOCKS;
+
+    /**
+     * @brief 패널 타이밍에 따른 주사율과 PSRAM 대역폭 사용량
+     * 
+     *        refresh rate and PSRAM bandwidth usage of a panel timing
+     */
+    struct timing_budget {
+        // 0.01Hz 단위 주사율
+        // refresh rate in units of 0.01Hz
+        uint32_t refresh_centihz;
+
+        uint32_t frame_period_us;
+
+        // 활성 라인 주사 중 최대 대역폭(B/s), 패널은 픽셀 클록마다 RGB565 픽셀 하나(2B)를 읽어 감
+        // peak bandwidth while scanning an active line(B/s), the panel fetches one RGB565 pixel(2B) per pixel clock
+        uint32_t scan_bw;
+
+        // COFFEE_PSRAM_RENDER_PCT에 따라 렌더링에 남겨둔 대역폭(B/s)
+        // bandwidth left for rendering by COFFEE_PSRAM_RENDER_PCT(B/s)
+        uint32_t render_bw;
+
+        // COFFEE_PSRAM_SD_BW에 따라 SD 카드 스트리밍에 남겨둔 대역폭(B/s)
+        // bandwidth left for SD card streaming by COFFEE_PSRAM_SD_BW(B/s)
+        uint32_t sd_bw;
+
+        // PSRAM 이론 대역폭(B/s)
+        // theoretical PSRAM bandwidth(B/s)
+        uint32_t psram_bw;
+
+        // 세 사용량의 합이 이론 대역폭에서 차지하는 비율
+        // share of the theoretical bandwidth taken by the three together
+        uint8_t load_pct;
+
+        // load_pct가 COFFEE_PSRAM_BW_BUDGET 이내인지 여부
+        // whether load_pct is within COFFEE_PSRAM_BW_BUDGET
+        bool fits;
+    };
+
+    /**
+     * @brief 화면 주사 통계
+     * 
+     *        scanout statistics
+     */
+    struct scan_stats {
+        uint32_t frames;
+
+        // LCD의 GDMA 출력 FIFO가 비어 패널에 픽셀을 제때 주지 못한(언더런) 프레임 수, LCD의 DMA 채널을 찾지 못했다면 세지 않음
+        // number of frames in which the LCD's GDMA output FIFO ran empty and could not feed the panel in time(underrun), not counted if the LCD's DMA channel was not found
+        uint32_t underruns;
+
+        uint32_t last_period_us;
+
+        uint32_t expected_period_us;
+
+        int64_t last_vsync_us;
+    };
+
+    /**
+     * @brief lvgl이 화면의 한 영역을 내보낸 직후 lcd를 점유한 상태로 호출되는 함수
+     * 
+     *        function called right after lvgl flushed a region of the screen, while lcd is locked
+     */
+    typedef void (*flush_hook_t)(const lv_area_t* area);
+
+    /**
+     * @brief 버스 설정에 패널 타이밍을 적용합니다
+     * 
+     *        applies a panel timing to the bus configuration
+     */
+    void apply_timing(lgfx::Bus_RGB::config_t& cfg, const panel_timing& timing);
+
+    /**
+     * @brief 보드 설명에 따라 구성되는 RGB 패널 장치
+     * 
+     *        RGB panel device configured from a board description
+     * 
+     * @tparam Board 보드 설명(board.hpp)
+     * 
+     *               board description(board.hpp)
+     */
+    template <typename Board>
+    class basic_lcd: public lgfx::LGFX_Device
     {
     public:
         lgfx::Panel_RGB _panel;
 
         lgfx::Bus_RGB _bus;
 
-        LCD(void);
+        basic_lcd(void)
+        {
+            {
+                // 패널 기본 정보 설정
+                // set panel preferences
+                auto cfg = _panel.config();
+                cfg.memory_width = Board::width;
+                cfg.memory_height = Board::height;
+                cfg.panel_width = Board::width;
+                cfg.panel_height = Board::height;
+                cfg.offset_x = 0;
+                cfg.offset_y = 0;
+                _panel.config(cfg);
+            }
+
+            {
+                // 버스 정보 설정
+                // set bus information
+                auto cfg = _bus.config();
+                cfg.panel = &_panel;
+
+                cfg.pin_d0 = Board::pin_d[0];
+                cfg.pin_d1 = Board::pin_d[1];
+                cfg.pin_d2 = Board::pin_d[2];
+                cfg.pin_d3 = Board::pin_d[3];
+                cfg.pin_d4 = Board::pin_d[4];
+
+                cfg.pin_d5 = Board::pin_d[5];
+                cfg.pin_d6 = Board::pin_d[6];
+                cfg.pin_d7 = Board::pin_d[7];
+                cfg.pin_d8 = Board::pin_d[8];
+                cfg.pin_d9 = Board::pin_d[9];
+                cfg.pin_d10 = Board::pin_d[10];
+
+                cfg.pin_d11 = Board::pin_d[11];
+                cfg.pin_d12 = Board::pin_d[12];
+                cfg.pin_d13 = Board::pin_d[13];
+                cfg.pin_d14 = Board::pin_d[14];
+                cfg.pin_d15 = Board::pin_d[15];
+
+                cfg.pin_henable = Board::pin_henable;
+                cfg.pin_vsync = Board::pin_vsync;
+                cfg.pin_hsync = Board::pin_hsync;
+                cfg.pin_pclk = Board::pin_pclk;
+
+                cfg.hsync_polarity = 0;
+                cfg.vsync_polarity = 0;
+
+                apply_timing(cfg, Board::timings[COFFEE_TIMING_PROFILE]);
+
+                cfg.pclk_active_neg = 1;
+                cfg.de_idle_high = 0;
+                cfg.pclk_idle_high = 0;
+
+                _bus.config(cfg);
+            }
+
+            _panel.setBus(&_bus);
+
+            setPanel(&_panel);
+        }
     };
 
+    using LCD = basic_lcd<board>;
+
     /**
      * @brief 디스플레이 출력과 관련된 객체
      * 
@@ -86,5 +314,99 @@ namespace coffee
      *         LCD initialization success
      */
     bool init_lcd(void);
+
+    /**
+     * @brief 패널 타이밍의 주사율과 PSRAM 대역폭 사용량을 계산합니다
+     * 
+     *        calculates the refresh rate and PSRAM bandwidth usage of a panel timing
+     * 
+     * @param timing 계산할 패널 타이밍
+     * 
+     *               panel timing to calculate
+     * 
+     * @param budget 계산 결과가 저장될 구조체
+     * 
+     *               structure to store the result
+     * 
+     * @return 대역폭 예산 이내인지 여부
+     * 
+     *         whether the timing is within the bandwidth budget
+     */
+    bool check_timing(const panel_timing& timing, timing_budget* budget);
+
+    /**
+     * @brief 패널 타이밍 프로파일을 바꿉니다, init_lcd() 이후에는 lcd를 점유한 채 버스를 새 타이밍으로 다시 초기화합니다
+     * 
+     *        switches the panel timing profile, after init_lcd() the bus is reinitialized with the new timing while lcd is locked
+     * 
+     * @param profile 바꿀 타이밍 프로파일
+     * 
+     *                timing profile to switch to
+     * 
+     * @return 타이밍 변경 성공 여부, 대역폭 예산을 넘으면 실패합니다
+     * 
+     *         timing switch success, fails if the profile exceeds the bandwidth budget
+     */
+    bool set_timing(timing_profile profile);
+
+    /**
+     * @brief 현재 패널 타이밍 프로파일을 가져옵니다
+     * 
+     *        gets the current panel timing profile
+     */
+    timing_profile get_timing(void);
+
+    /**
+     * @brief 다음 vsync까지 기다립니다
+     * 
+     *        waits for the next vsync
+     * 
+     * @param timeout_ms 최대 대기 시간
+     * 
+     *                   maximum time to wait
+     * 
+     * @return 제한 시간 안에 vsync가 발생했는지 여부
+     * 
+     *         whether a vsync occurred in time
+     */
+    bool wait_vsync(uint32_t timeout_ms);
+
+    /**
+     * @brief lvgl 외의 태스크에서 lcd에 그리기 전에 lcd를 점유합니다
+     * 
+     *        locks lcd before drawing to it from a task other than lvgl
+     * 
+     * @return 제한 시간 안에 점유했는지 여부
+     * 
+     *         whether lcd was locked in time
+     */
+    bool lock_lcd(TickType_t ticks = portMAX_DELAY);
+
+    void unlock_lcd(void);
+
+    /**
+     * @brief lvgl이 화면을 내보낼 때마다 호출될 함수를 설정합니다
+     * 
+     *        sets the function to be called whenever lvgl flushes the screen
+     * 
+     * @param hook 호출될 함수, 해제하려면 nullptr
+     * 
+     *             function to be called, nullptr to unset
+     */
+    void set_flush_hook(flush_hook_t hook);
+
+    /**
+     * @brief 화면 주사 통계를 가져옵니다
+     * 
+     *        gets the scanout statistics
+     */
+    void get_scan_stats(scan_stats* stats);
+
+    /**
+     * @brief 화면 주사 통계를 초기화합니다
+     * 
+     *        resets the scanout statistics
+     */
+    void reset_scan_stats(void);
 }
 #endif
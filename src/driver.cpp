@@ -10,10 +10,16 @@ namespace coffee
         if(!init_lcd())
             return false;
 
-        if(!init_touch())
+        // 터치 컨트롤러가 없는 보드는 입력 장치 없이 동작
+        // boards without a touch controller run without an input device
+        if(!init_touch() && board::touch != TOUCH_NONE)
             return false;
 
-        if(!init_sd(COFFEE_FS_LETTER))
+        bool assets = init_assets(COFFEE_ASSETS_LETTER);
+
+        // 에셋 파티션이 있다면 SD 카드 없이도 동작할 수 있음
+        // with an asset partition, the driver can work without an SD card
+        if(!init_sd(COFFEE_FS_LETTER) && !assets)
             return false;
 
         return true;
@@ -1,10 +1,16 @@
 #ifndef COFFEE_DRIVER_HPP
 #define COFFEE_DRIVER_HPP
 
+#include "assets.hpp"
 #include "def.h"
 #include "display.hpp"
+#include "i2c.hpp"
+#include "kv.hpp"
+#include "latency.hpp"
+#include "mem.hpp"
 #include "sd.hpp"
 #include "touch.hpp"
+#include "video.hpp"
 
 namespace coffee
 {
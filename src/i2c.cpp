@@ -0,0 +1,191 @@
+#include "i2c.hpp"
+
+#include <string.h>
+
+namespace coffee
+{
+    basic_i2c_bus<board> i2c(Wire);
+
+    i2c_bus::i2c_bus(TwoWire& wire, int sda, int scl): _wire(wire), _sda(sda), _scl(scl), _freq(0), _mutex(nullptr), _stats()
+    {
+    }
+
+    bool i2c_bus::begin(uint32_t freq)
+    {
+        if(_mutex)
+            return set_clock(freq);
+
+        _mutex = xSemaphoreCreateRecursiveMutex();
+        if(!_mutex) {
+            Serial.println("error: failed to create I2C bus mutex");
+
+            return false;
+        }
+
+        if(!_wire.begin(_sda, _scl, freq)) {
+            vSemaphoreDelete(_mutex);
+            _mutex = nullptr;
+
+            return false;
+        }
+
+        _wire.setTimeOut(COFFEE_I2C_TIMEOUT_MS);
+
+        _freq = freq;
+
+        return true;
+    }
+
+    bool i2c_bus::set_clock(uint32_t freq)
+    {
+        if(freq == _freq)
+            return true;
+
+        if(!lock())
+            return false;
+
+        bool ok = _wire.setClock(freq);
+        if(ok)
+            _freq = freq;
+
+        unlock();
+
+        return ok;
+    }
+
+    bool i2c_bus::lock(uint32_t timeout_ms)
+    {
+        if(!_mutex)
+            return false;
+
+        return xSemaphoreTakeRecursive(_mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+    }
+
+    void i2c_bus::unlock(void)
+    {
+        xSemaphoreGiveRecursive(_mutex);
+    }
+
+    bool i2c_bus::write(uint8_t addr, const uint8_t* tx, size_t tx_len)
+    {
+        uint32_t start = micros();
+
+        if(!lock()) {
+            record(addr, false, true, micros() - start);
+
+            return false;
+        }
+
+        _wire.beginTransmission(addr);
+        _wire.write(tx, tx_len);
+
+        bool ok = _wire.endTransmission() == 0;
+
+        record(addr, ok, false, micros() - start);
+
+        unlock();
+
+        return ok;
+    }
+
+    bool i2c_bus::write_read(uint8_t addr, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len)
+    {
+        uint32_t start = micros();
+
+        if(!lock()) {
+            record(addr, false, true, micros() - start);
+
+            return false;
+        }
+
+        _wire.beginTransmission(addr);
+        _wire.write(tx, tx_len);
+
+        bool ok = _wire.endTransmission(false) == 0 && _wire.requestFrom((uint16_t) addr, rx_len, true) == rx_len;
+
+        if(ok)
+            _wire.readBytes(rx, rx_len);
+
+        record(addr, ok, false, micros() - start);
+
+        unlock();
+
+        return ok;
+    }
+
+    bool i2c_bus::get_stats(uint8_t addr, i2c_stats* stats)
+    {
+        bool found = false;
+
+        portENTER_CRITICAL(&_stats_lock);
+
+        for(const i2c_stats& entry: _stats)
+            if(entry.transactions && entry.addr == addr) {
+                *stats = entry;
+                found = true;
+
+                break;
+            }
+
+        portEXIT_CRITICAL(&_stats_lock);
+
+        return found;
+    }
+
+    void i2c_bus::print_stats(void)
+    {
+        i2c_stats snapshot[COFFEE_I2C_MAX_DEVICES];
+
+        portENTER_CRITICAL(&_stats_lock);
+        memcpy(snapshot, _stats, sizeof(snapshot));
+        portEXIT_CRITICAL(&_stats_lock);
+
+        Serial.printf("I2C bus(%uHz):\n", _freq);
+
+        for(const i2c_stats& entry: snapshot) {
+            if(!entry.transactions)
+                continue;
+
+            Serial.printf("%*s0x%02X: %u transactions, %u errors, %u timeouts, latency avg %uus / max %uus\n", 4, "",
+                          entry.addr, entry.transactions, entry.errors, entry.timeouts,
+                          (uint32_t) (entry.total_us / entry.transactions), entry.max_us);
+        }
+    }
+
+    TwoWire& i2c_bus::wire(void)
+    {
+        return _wire;
+    }
+
+    void i2c_bus::record(uint8_t addr, bool ok, bool timeout, uint32_t elapsed_us)
+    {
+        portENTER_CRITICAL(&_stats_lock);
+
+        i2c_stats* stats = nullptr;
+
+        for(i2c_stats& entry: _stats)
+            if(!entry.transactions || entry.addr == addr) {
+                stats = &entry;
+
+                break;
+            }
+
+        if(stats) {
+            stats->addr = addr;
+            stats->transactions++;
+
+            if(timeout)
+                stats->timeouts++;
+            else if(!ok)
+                stats->errors++;
+
+            stats->last_us = elapsed_us;
+            stats->total_us += elapsed_us;
+
+            if(elapsed_us > stats->max_us)
+                stats->max_us = elapsed_us;
+        }
+
+        portEXIT_CRITICAL(&_stats_lock);
+    }
+}
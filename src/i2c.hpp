@@ -0,0 +1,203 @@
+#ifndef COFFEE_I2C_HPP
+#define COFFEE_I2C_HPP
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "def.h"
+
+/**
+ * @def COFFEE_I2C_FREQ
+ * 
+ * @brief I2C 버스 클록입니다(최대 400kHz, fast mode)
+ * 
+ *        통신이 불안정하다면 이 값을 100000으로 바꾸세요
+ * 
+ *        I2C bus clock(up to 400kHz, fast mode)
+ * 
+ *        if communication is unstable, change this value to 100000
+ */
+#define COFFEE_I2C_FREQ 400000
+
+/**
+ * @def COFFEE_I2C_TIMEOUT_MS
+ * 
+ * @brief 버스 점유 및 트랜잭션 하나에 허용되는 최대 시간입니다
+ * 
+ *        maximum time allowed for acquiring the bus and for a single transaction
+ */
+#define COFFEE_I2C_TIMEOUT_MS 50
+
+/**
+ * @def COFFEE_I2C_MAX_DEVICES
+ * 
+ * @brief 통계를 기록할 수 있는 최대 장치 수입니다
+ * 
+ *        maximum number of devices statistics are kept for
+ */
+#define COFFEE_I2C_MAX_DEVICES 8
+
+namespace coffee
+{
+    /**
+     * @brief 장치 하나에 대한 I2C 트랜잭션 통계
+     * 
+     *        I2C transaction statistics of a single device
+     */
+    struct i2c_stats {
+        uint8_t addr;
+
+        uint32_t transactions;
+
+        // NACK 등 전송 실패 수
+        // number of failed transfers such as NACKs
+        uint32_t errors;
+
+        // 버스를 제한 시간 안에 점유하지 못한 수
+        // number of times the bus could not be acquired in time
+        uint32_t timeouts;
+
+        uint32_t last_us;
+
+        uint32_t max_us;
+
+        uint64_t total_us;
+    };
+
+    /**
+     * @brief 여러 장치와 태스크가 공유하는 I2C 버스
+     * 
+     *        모든 트랜잭션은 재귀 뮤텍스로 직렬화되며, 여러 트랜잭션을 묶으려면 lock()과 unlock()을 사용합니다
+     * 
+     *        I2C bus shared by multiple devices and tasks
+     * 
+     *        every transaction is serialized by a recursive mutex, use lock() and unlock() to group several transactions
+     */
+    class i2c_bus
+    {
+    public:
+        i2c_bus(TwoWire& wire, int sda, int scl);
+
+        /**
+         * @brief 버스를 초기화합니다, 이미 초기화되었다면 클록만 설정합니다
+         * 
+         *        initializes the bus, only sets the clock if already initialized
+         * 
+         * @param freq 버스 클록(Hz)
+         * 
+         *             bus clock(Hz)
+         * 
+         * @return 버스 초기화 성공 여부
+         * 
+         *         bus initialization success
+         */
+        bool begin(uint32_t freq = COFFEE_I2C_FREQ);
+
+        /**
+         * @brief 버스 클록을 변경합니다
+         * 
+         *        changes the bus clock
+         */
+        bool set_clock(uint32_t freq);
+
+        /**
+         * @brief 버스를 점유합니다
+         * 
+         *        acquires the bus
+         * 
+         * @return 제한 시간 안에 점유했는지 여부
+         * 
+         *         whether the bus was acquired in time
+         */
+        bool lock(uint32_t timeout_ms = COFFEE_I2C_TIMEOUT_MS);
+
+        void unlock(void);
+
+        /**
+         * @brief 장치에 데이터를 씁니다
+         * 
+         *        writes data to a device
+         */
+        bool write(uint8_t addr, const uint8_t* tx, size_t tx_len);
+
+        /**
+         * @brief 장치에 데이터를 쓴 뒤 재시작 조건으로 이어서 읽습니다(버스트 레지스터 읽기)
+         * 
+         *        writes data to a device, then reads after a repeated start(burst register read)
+         */
+        bool write_read(uint8_t addr, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len);
+
+        /**
+         * @brief 장치의 트랜잭션 통계를 가져옵니다
+         * 
+         *        gets the transaction statistics of a device
+         * 
+         * @return 해당 장치의 기록이 있는지 여부
+         * 
+         *         whether there is a record for the device
+         */
+        bool get_stats(uint8_t addr, i2c_stats* stats);
+
+        /**
+         * @brief 모든 장치의 트랜잭션 통계를 출력합니다
+         * 
+         *        prints the transaction statistics of every device
+         */
+        void print_stats(void);
+
+        TwoWire& wire(void);
+
+    private:
+        TwoWire& _wire;
+
+        int _sda;
+
+        int _scl;
+
+        uint32_t _freq;
+
+        SemaphoreHandle_t _mutex;
+
+        i2c_stats _stats[COFFEE_I2C_MAX_DEVICES];
+
+        // 버스를 점유하지 못한 타임아웃도 기록하므로, 통계 테이블은 버스 뮤텍스와 별개로 잠금
+        // timeouts are recorded without the bus, so the statistics table has its own lock apart from the bus mutex
+        portMUX_TYPE _stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+        /**
+         * @brief 트랜잭션 하나의 결과를 장치 통계에 기록합니다
+         * 
+         *        records the result of a single transaction to the device statistics
+         */
+        void record(uint8_t addr, bool ok, bool timeout, uint32_t elapsed_us);
+    };
+
+    /**
+     * @brief 보드 설명의 I2C 핀으로 구성되는 I2C 버스
+     * 
+     *        I2C bus configured with the I2C pins of a board description
+     * 
+     * @tparam Board 보드 설명(board.hpp)
+     * 
+     *               board description(board.hpp)
+     */
+    template <typename Board>
+    class basic_i2c_bus: public i2c_bus
+    {
+    public:
+        basic_i2c_bus(TwoWire& wire): i2c_bus(wire, Board::i2c_sda, Board::i2c_scl)
+        {
+        }
+    };
+
+    /**
+     * @brief PCA9557과 GT911이 연결된 I2C 버스
+     * 
+     *        I2C bus the PCA9557 and the GT911 are connected to
+     */
+    extern basic_i2c_bus<board> i2c;
+}
+#endif
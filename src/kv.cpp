@@ -0,0 +1,938 @@
+#include "kv.hpp"
+
+#include <string.h>
+#include <unistd.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_pthread.h>
+
+#include "sd.hpp"
+#endif
+
+#define KV_MAGIC "CFKV"
+#define KV_VERSION 1
+
+// 파일 헤더: 매직(4B), 버전(4B)
+// file header: magic(4B), version(4B)
+#define KV_FILE_HEADER_SIZE 8
+
+// 레코드 헤더: CRC(4B), 종류(1B), 예약(1B), 키 길이(2B), 값 길이(4B), 모두 little endian
+// CRC는 자신을 제외한 레코드 전체에 대해 계산함
+// record header: CRC(4B), type(1B), reserved(1B), key length(2B), value length(4B), all little endian
+// the CRC covers the whole record except itself
+#define KV_RECORD_HEADER_SIZE 12
+
+#define KV_PUT 1
+#define KV_REMOVE 2
+
+// 묶음을 닫는 레코드, 값 길이 자리에 묶음의 레코드 수를 담음
+// record closing a batch, holds the number of records in the batch in place of the value length
+#define KV_COMMIT 3
+
+namespace coffee
+{
+    static uint32_t crc32(const uint8_t* data, size_t len);
+
+    static void put_u16(std::string& out, uint16_t v);
+
+    static void put_u32(std::string& out, uint32_t v);
+
+    static uint16_t get_u16(const uint8_t* p);
+
+    static uint32_t get_u32(const uint8_t* p);
+
+    /**
+     * @brief 레코드 하나를 만듭니다
+     * 
+     *        encodes a single record
+     */
+    static std::string encode_record(uint8_t type, const std::string& key, const std::string& value, uint32_t value_len);
+
+    /**
+     * @brief 압축 중에 사용하는 파일 경로, 확장자를 .tmp로 바꿈
+     * 
+     *        file path used during compaction, the extension changed to .tmp
+     */
+    static std::string tmp_path(const std::string& path);
+
+    /**
+     * @brief 파일의 현재 위치에서 CRC가 맞는 레코드 하나를 읽습니다
+     * 
+     *        reads a single CRC-checked record at the current position of a file
+     * 
+     * @param count 묶음에서 지금까지 읽은 레코드 수, 커밋 레코드를 검증하는 데 사용
+     * 
+     *              number of records read so far in the batch, used to verify a commit record
+     */
+    static bool read_record(FILE* file, uint32_t count, std::string* record);
+
+    /**
+     * @brief 주어진 위치부터 CRC가 맞는 커밋 레코드를 찾습니다
+     * 
+     *        searches for a CRC-checked commit record from the given position
+     * 
+     * @param start 손상된 묶음의 시작 위치
+     * 
+     *              start of the corrupt batch
+     * 
+     * @param read 손상된 레코드 앞에서 읽은 묶음의 레코드 수, 커밋 레코드의 레코드 수는 이보다 많고 건너뛰는 구간에 들어가야 함
+     * 
+     *             number of records of the batch read before the corrupt one, the record count of the commit record must exceed it and fit in the skipped span
+     * 
+     * @return 찾은 커밋 레코드의 끝, 없다면 0
+     * 
+     *         end of the commit record found, 0 if there is none
+     */
+    static uint32_t find_commit(FILE* file, uint32_t from, uint32_t size, uint32_t start, uint32_t read);
+
+    /**
+     * @brief 파일에 버퍼의 내용을 쓰고 저장 장치까지 동기화합니다
+     * 
+     *        writes a buffer to a file and syncs it down to the storage device
+     */
+    static bool write_synced(FILE* file, const std::string& data);
+
+    /**
+     * @brief 작업 하나 동안 SD 카드를 점유합니다, SD 카드 밖의 경로나 호스트에서는 아무것도 하지 않습니다
+     * 
+     *        holds the SD card for a single operation, does nothing for paths outside the SD card or on a host
+     */
+    class card_hold
+    {
+    public:
+        explicit card_hold(const std::string& path);
+
+        ~card_hold(void);
+
+        // 점유에 실패했다면, 즉 SD 카드가 마운트되지 않았다면 false
+        // false if holding failed, that is the SD card is not mounted
+        bool ok(void) const;
+
+    private:
+        bool _held;
+
+        bool _ok;
+    };
+
+    static bool on_sd(const std::string& path);
+
+    void kv_batch::put(const std::string& key, const std::string& value)
+    {
+        if(key.empty() || key.size() > COFFEE_KV_MAX_KEY || value.size() > COFFEE_KV_MAX_VALUE) {
+            _invalid = true;
+
+            return;
+        }
+
+        _records += encode_record(KV_PUT, key, value, value.size());
+        _count++;
+    }
+
+    void kv_batch::remove(const std::string& key)
+    {
+        if(key.empty() || key.size() > COFFEE_KV_MAX_KEY) {
+            _invalid = true;
+
+            return;
+        }
+
+        _records += encode_record(KV_REMOVE, key, "", 0);
+        _count++;
+    }
+
+    void kv_batch::clear(void)
+    {
+        _records.clear();
+        _count = 0;
+        _invalid = false;
+    }
+
+    bool kv_batch::empty(void) const
+    {
+        return !_count;
+    }
+
+    card_hold::card_hold(const std::string& path) : _held(on_sd(path)), _ok(true)
+    {
+#ifdef ESP_PLATFORM
+        if(_held)
+            _ok = _held = hold_sd();
+#endif
+    }
+
+    card_hold::~card_hold(void)
+    {
+#ifdef ESP_PLATFORM
+        if(_held)
+            release_sd();
+#endif
+    }
+
+    bool card_hold::ok(void) const
+    {
+        return _ok;
+    }
+
+    kv::kv(void) : _open(false), _cards(0), _end(0), _stats(), _compact_pending(false), _compacting(false), _stopping(false) {}
+
+    kv::~kv(void)
+    {
+        close();
+    }
+
+    bool kv::open(const char* path)
+    {
+        close();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _path = path;
+
+        card_hold hold(_path);
+        if(!hold.ok()) {
+            printf("error: SD card is not mounted, failed to open kv store(%s)\n", path);
+
+            return false;
+        }
+
+#ifdef ESP_PLATFORM
+        get_sd_mounts(&_cards);
+#endif
+
+        std::string tmp = tmp_path(_path);
+
+        // 원래 파일은 압축된 파일이 완성된 뒤에만 지워지므로, 원래 파일이 있다면 남은 압축 파일은 불완전함
+        // the original file is only removed after the compacted file is complete, so a leftover one is incomplete if the original exists
+        FILE* file = fopen(path, "rb");
+        if(file) {
+            fclose(file);
+
+            ::remove(tmp.c_str());
+        } else
+            ::rename(tmp.c_str(), path);
+
+        file = fopen(path, "rb");
+        if(!file) {
+            file = fopen(path, "w+b");
+
+            std::string header(KV_MAGIC);
+            put_u32(header, KV_VERSION);
+
+            if(file && !write_synced(file, header)) {
+                fclose(file);
+                file = nullptr;
+            }
+        }
+
+        if(!file) {
+            printf("error: failed to open kv store(%s)\n", path);
+
+            return false;
+        }
+
+        bool ok = recover(file);
+
+        fclose(file);
+
+        if(!ok) {
+            _index.clear();
+            _stats = kv_stats();
+
+            return false;
+        }
+
+        // 커밋되지 않은 꼬리를 잘라내야 다음 묶음이 그 뒤에 가려지지 않음
+        // the uncommitted tail must be cut off so that the next batch is not hidden behind it
+        if(_stats.discarded_bytes && truncate(path, _end))
+            printf("error: failed to truncate kv store(%s)\n", path);
+
+#ifdef ESP_PLATFORM
+        // 호출한 태스크가 이후에 만드는 pthread에 영향을 주지 않도록 원래 설정을 되돌림
+        // restores the previous config so that pthreads the caller creates later are not affected
+        esp_pthread_cfg_t saved;
+        bool had_cfg = esp_pthread_get_cfg(&saved) == ESP_OK;
+
+        esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+        cfg.stack_size = 4096;
+        cfg.thread_name = "kv_compact";
+        esp_pthread_set_cfg(&cfg);
+#endif
+
+        _open = true;
+        _stopping = false;
+        _compact_pending = should_compact();
+        _compactor = std::thread(&kv::compactor_loop, this);
+
+#ifdef ESP_PLATFORM
+        if(!had_cfg)
+            saved = esp_pthread_get_default_config();
+
+        esp_pthread_set_cfg(&saved);
+#endif
+
+        return true;
+    }
+
+    void kv::close(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+
+        _wake.notify_all();
+
+        if(_compactor.joinable())
+            _compactor.join();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _open = false;
+
+        _index.clear();
+        _stats = kv_stats();
+        _end = 0;
+    }
+
+    bool kv::get(const std::string& key, std::string* value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _index.find(key);
+        if(it == _index.end() || !_open)
+            return false;
+
+        card_hold hold(_path);
+
+        FILE* file = (hold.ok() && same_card()) ? fopen(_path.c_str(), "rb") : nullptr;
+
+        value->resize(it->second.length);
+
+        bool ok = file && !fseek(file, it->second.offset, SEEK_SET)
+                  && fread(&(*value)[0], 1, it->second.length, file) == it->second.length;
+
+        if(file)
+            fclose(file);
+
+        if(!ok)
+            printf("error: failed to read kv value(%s)\n", key.c_str());
+
+        return ok;
+    }
+
+    bool kv::contains(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        return _index.count(key);
+    }
+
+    bool kv::put(const std::string& key, const std::string& value)
+    {
+        kv_batch batch;
+        batch.put(key, value);
+
+        return commit(batch);
+    }
+
+    bool kv::remove(const std::string& key)
+    {
+        kv_batch batch;
+        batch.remove(key);
+
+        return commit(batch);
+    }
+
+    bool kv::commit(kv_batch& batch)
+    {
+        if(batch._invalid) {
+            printf("error: kv key or value is empty or too long\n");
+
+            batch.clear();
+
+            return false;
+        }
+
+        if(batch.empty())
+            return true;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if(!_open)
+            return false;
+
+        card_hold hold(_path);
+        if(!hold.ok() || !same_card()) {
+            printf("error: failed to append to kv store(%s)\n", _path.c_str());
+
+            return false;
+        }
+
+        std::string data = batch._records + encode_record(KV_COMMIT, "", "", batch._count);
+
+        uint32_t base = _end;
+
+        if(!append(data))
+            return false;
+
+        apply(batch._records, base);
+
+        _end += data.size();
+
+        _stats.file_bytes = _end;
+        _stats.commits++;
+
+        batch.clear();
+
+        if(should_compact()) {
+            _compact_pending = true;
+
+            _wake.notify_one();
+        }
+
+        return true;
+    }
+
+    bool kv::compact(void)
+    {
+        std::string tmp;
+
+        std::unordered_map<std::string, location> snapshot;
+        uint32_t snapshot_end;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if(!_open || _compacting)
+                return false;
+
+            _compacting = true;
+
+            tmp = tmp_path(_path);
+
+            snapshot = _index;
+            snapshot_end = _end;
+        }
+
+        // 스냅샷의 값들은 덧붙이기만 하는 파일에서 바뀌지 않으므로 잠그지 않은 채 옮겨 적음
+        // the values of the snapshot do not change in the append-only file, so they are copied without locking
+        std::unordered_map<std::string, location> index;
+        uint32_t end = 0;
+
+        bool ok = write_compacted(tmp, snapshot, &index, &end);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _compacting = false;
+
+        ok = ok && swap_compacted(tmp, snapshot_end, index, end);
+
+        if(!ok) {
+            printf("error: failed to compact kv store(%s)\n", _path.c_str());
+
+            card_hold hold(_path);
+
+            if(hold.ok())
+                ::remove(tmp.c_str());
+        }
+
+        return ok;
+    }
+
+    void kv::get_stats(kv_stats* stats)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        *stats = _stats;
+        stats->keys = _index.size();
+    }
+
+    bool kv::recover(FILE* file)
+    {
+        uint8_t header[KV_FILE_HEADER_SIZE];
+
+        if(fseek(file, 0, SEEK_SET) || fread(header, 1, sizeof(header), file) != sizeof(header)
+           || memcmp(header, KV_MAGIC, 4) || get_u32(header + 4) != KV_VERSION) {
+            printf("error: not a kv store(%s)\n", _path.c_str());
+
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        uint32_t size = ftell(file);
+
+        fseek(file, KV_FILE_HEADER_SIZE, SEEK_SET);
+
+        uint32_t pos = KV_FILE_HEADER_SIZE;
+        uint32_t end = pos;
+
+        // 커밋 레코드를 만나기 전까지의 레코드들
+        // records seen since the last commit record
+        std::string batch;
+        uint32_t count = 0;
+
+        std::string record;
+
+        while(true) {
+            if(read_record(file, count, &record)) {
+                pos += record.size();
+
+                if(record[4] == KV_COMMIT) {
+                    apply(batch, end);
+
+                    batch.clear();
+                    count = 0;
+
+                    end = pos;
+                } else {
+                    batch += record;
+                    count++;
+                }
+
+                continue;
+            }
+
+            if(pos >= size)
+                break;
+
+            // 잘못된 레코드 뒤에 유효한 커밋 레코드가 있다면 꼬리가 끊긴 것이 아니라 중간이 손상된 것이므로,
+            // 뒤의 커밋된 묶음들을 잃지 않도록 손상된 묶음만 건너뜀
+            // a valid commit record after a bad record means the middle is corrupt rather than the tail being torn,
+            // so only the corrupt batch is skipped to keep the committed batches after it
+            uint32_t next = find_commit(file, pos + 1, size, end, count);
+            if(!next)
+                break;
+
+            printf("warning: skipping %uB of corrupt kv records at %u(%s)\n", (unsigned) (next - end), (unsigned) end, _path.c_str());
+
+            _stats.corrupt_bytes += next - end;
+
+            batch.clear();
+            count = 0;
+
+            pos = end = next;
+
+            fseek(file, pos, SEEK_SET);
+        }
+
+        _end = end;
+
+        _stats.file_bytes = end;
+
+        if(end < size) {
+            printf("warning: discarding %uB of uncommitted kv records(%s)\n", (unsigned) (size - end), _path.c_str());
+
+            _stats.discarded_bytes = size - end;
+        }
+
+        return true;
+    }
+
+    bool kv::append(const std::string& data)
+    {
+        FILE* file = fopen(_path.c_str(), "r+b");
+
+        bool ok = file && !fseek(file, _end, SEEK_SET) && write_synced(file, data);
+
+        if(file)
+            fclose(file);
+
+        if(ok)
+            return true;
+
+        printf("error: failed to append to kv store(%s)\n", _path.c_str());
+
+        // 일부만 기록된 묶음이 다음 마운트에서 되살아나지 않도록 잘라냄
+        // cuts off the partially written batch so that it does not come back at the next mount
+        truncate(_path.c_str(), _end);
+
+        return false;
+    }
+
+    void kv::apply(const std::string& records, uint32_t base)
+    {
+        const uint8_t* p = (const uint8_t*) records.data();
+        const uint8_t* end = p + records.size();
+
+        while(p < end) {
+            uint8_t type = p[4];
+            uint16_t key_len = get_u16(p + 6);
+            uint32_t value_len = (type == KV_PUT) ? get_u32(p + 8) : 0;
+
+            uint32_t record_size = KV_RECORD_HEADER_SIZE + key_len + value_len;
+
+            // 압축 중 커밋된 묶음들을 그대로 반영할 때는 커밋 레코드도 섞여 있음
+            // commit records are mixed in when applying the batches committed during compaction as is
+            if(type == KV_COMMIT) {
+                p += record_size;
+
+                continue;
+            }
+
+            std::string key((const char*) p + KV_RECORD_HEADER_SIZE, key_len);
+
+            auto it = _index.find(key);
+            if(it != _index.end()) {
+                _stats.live_bytes -= it->second.record_size;
+
+                if(type == KV_REMOVE)
+                    _index.erase(it);
+            }
+
+            if(type == KV_PUT) {
+                uint32_t offset = base + (p - (const uint8_t*) records.data()) + KV_RECORD_HEADER_SIZE + key_len;
+
+                _index[key] = { offset, value_len, record_size };
+
+                _stats.live_bytes += record_size;
+            }
+
+            p += record_size;
+        }
+    }
+
+    bool kv::write_compacted(const std::string& tmp, const std::unordered_map<std::string, location>& snapshot,
+                             std::unordered_map<std::string, location>* index, uint32_t* end)
+    {
+        std::string data(KV_MAGIC);
+        put_u32(data, KV_VERSION);
+
+        index->reserve(snapshot.size());
+
+        uint32_t pos = KV_FILE_HEADER_SIZE;
+        uint32_t count = 0;
+
+        bool ok = true;
+
+        std::string value;
+
+        auto entry = snapshot.begin();
+
+        // 현재 값들을 묶음 하나로 옮겨 적되, 쌓인 레코드를 적당한 크기마다 기록하여 메모리 사용을 제한하고 그동안만 SD 카드를 점유함
+        // copies the current values as a single batch, flushing accumulated records every so often to bound memory use and holding the SD card only meanwhile
+        for(bool first = true; ok; first = false) {
+            card_hold hold(_path);
+
+            FILE* in = (hold.ok() && same_card()) ? fopen(_path.c_str(), "rb") : nullptr;
+            FILE* out = in ? fopen(tmp.c_str(), first ? "wb" : "ab") : nullptr;
+
+            ok = out;
+
+            for(; ok && entry != snapshot.end() && data.size() < 16 * 1024; ++entry) {
+                value.resize(entry->second.length);
+
+                if(fseek(in, entry->second.offset, SEEK_SET)
+                   || fread(&value[0], 1, value.size(), in) != value.size()) {
+                    ok = false;
+
+                    break;
+                }
+
+                std::string record = encode_record(KV_PUT, entry->first, value, value.size());
+
+                (*index)[entry->first] = { (uint32_t) (pos + KV_RECORD_HEADER_SIZE + entry->first.size()), entry->second.length, (uint32_t) record.size() };
+
+                data += record;
+                pos += record.size();
+                count++;
+            }
+
+            bool last = entry == snapshot.end();
+
+            if(last) {
+                data += encode_record(KV_COMMIT, "", "", count);
+                pos += KV_RECORD_HEADER_SIZE;
+            }
+
+            ok = ok && (last ? write_synced(out, data) : fwrite(data.data(), 1, data.size(), out) == data.size());
+            data.clear();
+
+            if(out)
+                fclose(out);
+
+            if(in)
+                fclose(in);
+
+            if(last)
+                break;
+        }
+
+        *end = pos;
+
+        return ok;
+    }
+
+    bool kv::swap_compacted(const std::string& tmp, uint32_t snapshot_end, std::unordered_map<std::string, location>& index, uint32_t end)
+    {
+        if(!_open)
+            return false;
+
+        card_hold hold(_path);
+        if(!hold.ok() || !same_card())
+            return false;
+
+        // 압축하는 동안 커밋된 묶음들을 그대로 옮겨 붙임
+        // appends the batches committed during compaction as is
+        std::string delta(_end - snapshot_end, '\0');
+
+        FILE* in = fopen(_path.c_str(), "rb");
+        FILE* out = fopen(tmp.c_str(), "ab");
+
+        bool ok = in && out && (delta.empty() || (!fseek(in, snapshot_end, SEEK_SET) && fread(&delta[0], 1, delta.size(), in) == delta.size()))
+                  && write_synced(out, delta);
+
+        if(in)
+            fclose(in);
+
+        if(out)
+            fclose(out);
+
+        if(!ok)
+            return false;
+
+        // FAT의 rename()은 덮어쓰지 못하므로 원래 파일을 먼저 지움, 그 사이에 끊기면 open()이 복구함
+        // FAT rename() cannot overwrite, so the original is removed first, open() recovers if power is lost in between
+        ::remove(_path.c_str());
+
+        if(::rename(tmp.c_str(), _path.c_str())) {
+            printf("error: failed to replace kv store with the compacted one(%s)\n", _path.c_str());
+
+            // 다시 열면 open()이 압축된 파일로 복구함
+            // open() recovers with the compacted file when reopened
+            _open = false;
+
+            return false;
+        }
+
+        uint32_t live = 0;
+        for(const auto& entry: index)
+            live += entry.second.record_size;
+
+        _index.swap(index);
+
+        _stats.live_bytes = live;
+
+        apply(delta, end);
+
+        _end = end + delta.size();
+
+        _stats.file_bytes = _end;
+        _stats.compactions++;
+
+        return true;
+    }
+
+    bool kv::same_card(void) const
+    {
+#ifdef ESP_PLATFORM
+        uint32_t cards;
+        get_sd_mounts(&cards);
+
+        if(on_sd(_path) && cards != _cards) {
+            printf("error: the SD card holding kv store was replaced(%s)\n", _path.c_str());
+
+            return false;
+        }
+#endif
+
+        return true;
+    }
+
+    bool kv::should_compact(void) const
+    {
+        if(_end < COFFEE_KV_COMPACT_MIN)
+            return false;
+
+        uint32_t dead = _end - KV_FILE_HEADER_SIZE - _stats.live_bytes;
+
+        return (uint64_t) dead * 100 >= (uint64_t) _end * COFFEE_KV_COMPACT_PCT;
+    }
+
+    void kv::compactor_loop(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while(true) {
+            _wake.wait(lock, [this] { return _compact_pending || _stopping; });
+
+            if(_stopping)
+                break;
+
+            _compact_pending = false;
+
+            if(!should_compact())
+                continue;
+
+            // compact()는 스냅샷을 뜨고 바꿀 때만 잠금
+            // compact() only locks to take the snapshot and to swap
+            lock.unlock();
+
+            compact();
+
+            lock.lock();
+        }
+    }
+
+    static uint32_t crc32(const uint8_t* data, size_t len)
+    {
+        struct crc_table {
+            uint32_t entries[256];
+        };
+
+        // 함수 안의 정적 변수는 한 번만 스레드 안전하게 초기화되므로 호출한 스레드와 압축 스레드가 동시에 만들지 않음
+        // a function-local static is initialized once and thread-safely, so the calling thread and the compaction thread do not build it at the same time
+        static const crc_table table = [] {
+            crc_table t;
+
+            for(uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+
+                for(int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+                t.entries[i] = c;
+            }
+
+            return t;
+        }();
+
+        uint32_t crc = 0xFFFFFFFF;
+
+        for(size_t i = 0; i < len; i++)
+            crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+        return crc ^ 0xFFFFFFFF;
+    }
+
+    static void put_u16(std::string& out, uint16_t v)
+    {
+        out += (char) (v & 0xFF);
+        out += (char) (v >> 8);
+    }
+
+    static void put_u32(std::string& out, uint32_t v)
+    {
+        put_u16(out, v & 0xFFFF);
+        put_u16(out, v >> 16);
+    }
+
+    static uint16_t get_u16(const uint8_t* p)
+    {
+        return p[0] | p[1] << 8;
+    }
+
+    static uint32_t get_u32(const uint8_t* p)
+    {
+        return get_u16(p) | (uint32_t) get_u16(p + 2) << 16;
+    }
+
+    static std::string encode_record(uint8_t type, const std::string& key, const std::string& value, uint32_t value_len)
+    {
+        std::string record(4, '\0');
+
+        record += (char) type;
+        record += '\0';
+
+        put_u16(record, key.size());
+        put_u32(record, value_len);
+
+        record += key;
+        record += value;
+
+        uint32_t crc = crc32((const uint8_t*) record.data() + 4, record.size() - 4);
+
+        for(int i = 0; i < 4; i++)
+            record[i] = (char) (crc >> (i * 8));
+
+        return record;
+    }
+
+    static std::string tmp_path(const std::string& path)
+    {
+        size_t slash = path.rfind('/');
+        size_t dot = path.rfind('.');
+
+        if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return path + ".tmp";
+
+        return path.substr(0, dot) + ".tmp";
+    }
+
+    static bool write_synced(FILE* file, const std::string& data)
+    {
+        return fwrite(data.data(), 1, data.size(), file) == data.size() && !fflush(file) && !fsync(fileno(file));
+    }
+
+    static bool read_record(FILE* file, uint32_t count, std::string* record)
+    {
+        record->assign(KV_RECORD_HEADER_SIZE, '\0');
+
+        if(fread(&(*record)[0], 1, KV_RECORD_HEADER_SIZE, file) != KV_RECORD_HEADER_SIZE)
+            return false;
+
+        const uint8_t* p = (const uint8_t*) record->data();
+
+        uint8_t type = p[4];
+        uint16_t key_len = get_u16(p + 6);
+        uint32_t value_len = get_u32(p + 8);
+
+        if(type < KV_PUT || type > KV_COMMIT || key_len > COFFEE_KV_MAX_KEY || value_len > COFFEE_KV_MAX_VALUE
+           || (type == KV_REMOVE && value_len) || (type == KV_COMMIT && (key_len || value_len != count)))
+            return false;
+
+        uint32_t body = (type == KV_COMMIT) ? 0 : key_len + ((type == KV_PUT) ? value_len : 0);
+
+        record->resize(KV_RECORD_HEADER_SIZE + body);
+
+        if(body && fread(&(*record)[KV_RECORD_HEADER_SIZE], 1, body, file) != body)
+            return false;
+
+        p = (const uint8_t*) record->data();
+
+        return crc32(p + 4, record->size() - 4) == get_u32(p);
+    }
+
+    static uint32_t find_commit(FILE* file, uint32_t from, uint32_t size, uint32_t start, uint32_t read)
+    {
+        const uint32_t chunk = 4096;
+
+        std::string buf;
+
+        // 커밋 레코드가 조각 경계에 걸칠 수 있으므로 조각들은 헤더 크기만큼 겹침
+        // chunks overlap by a header size as a commit record can straddle their boundary
+        for(uint32_t at = from; at + KV_RECORD_HEADER_SIZE <= size; at += chunk - KV_RECORD_HEADER_SIZE + 1) {
+            uint32_t len = (size - at < chunk) ? size - at : chunk;
+
+            buf.resize(len);
+
+            if(fseek(file, at, SEEK_SET) || fread(&buf[0], 1, len, file) != len)
+                return 0;
+
+            const uint8_t* p = (const uint8_t*) buf.data();
+
+            // 값 안에 커밋 레코드와 똑같은 바이트들이 있지 않는 한, CRC까지 맞는 커밋 레코드는 실제 커밋임
+            // a commit record with a matching CRC is a real commit unless a value holds the exact same bytes
+            for(uint32_t i = 0; i + KV_RECORD_HEADER_SIZE <= len; i++) {
+                if(p[i + 4] != KV_COMMIT || p[i + 5] || get_u16(p + i + 6) || crc32(p + i + 4, 8) != get_u32(p + i))
+                    continue;
+
+                // 이미 읽은 레코드들과 손상된 레코드를 닫지 못하거나, 건너뛰는 구간에 그만큼의 레코드가 들어가지 않으면 이 묶음의 커밋이 아님
+                // not the commit of this batch if it cannot close the records already read plus the corrupt one, or that many records do not fit in the skipped span
+                uint32_t count = get_u32(p + i + 8);
+
+                if(count > read && (uint64_t) count * KV_RECORD_HEADER_SIZE <= at + i - start)
+                    return at + i + KV_RECORD_HEADER_SIZE;
+            }
+
+            if(len < chunk)
+                break;
+        }
+
+        return 0;
+    }
+
+    static bool on_sd(const std::string& path)
+    {
+        return !path.compare(0, 4, "/sd/");
+    }
+}
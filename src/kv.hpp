@@ -0,0 +1,308 @@
+#ifndef COFFEE_KV_HPP
+#define COFFEE_KV_HPP
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @def COFFEE_KV_PATH
+ * 
+ * @brief 기본 저장소 파일 경로입니다, SD 카드는 "/sd"에 마운트됩니다
+ * 
+ *        FAT의 긴 파일 이름이 꺼져 있으므로 8.3 형식이어야 하며, 압축 중에는 확장자를 .tmp로 바꾼 파일을 사용합니다
+ * 
+ *        default store file path, the SD card is mounted at "/sd"
+ * 
+ *        long FAT file names are disabled so it must be in 8.3 form, and compaction uses the file with its extension changed to .tmp
+ */
+#define COFFEE_KV_PATH "/sd/coffee.kv"
+
+/**
+ * @def COFFEE_KV_MAX_KEY
+ * 
+ * @brief 키의 최대 길이입니다
+ * 
+ *        maximum length of a key
+ */
+#define COFFEE_KV_MAX_KEY 255
+
+/**
+ * @def COFFEE_KV_MAX_VALUE
+ * 
+ * @brief 값의 최대 길이입니다
+ * 
+ *        maximum length of a value
+ */
+#define COFFEE_KV_MAX_VALUE (64 * 1024)
+
+/**
+ * @def COFFEE_KV_COMPACT_MIN
+ * 
+ * @brief 파일이 이보다 작으면 압축하지 않습니다
+ * 
+ *        the file is not compacted while it is smaller than this
+ */
+#define COFFEE_KV_COMPACT_MIN (64 * 1024)
+
+/**
+ * @def COFFEE_KV_COMPACT_PCT
+ * 
+ * @brief 파일에서 덮어쓰이거나 지워진 레코드의 비율이 이 값(%) 이상이면 백그라운드에서 압축합니다
+ * 
+ *        the file is compacted in the background once overwritten or removed records make up this share(%) of it
+ */
+#define COFFEE_KV_COMPACT_PCT 50
+
+namespace coffee
+{
+    /**
+     * @brief 한 번에 커밋되는 변경 묶음
+     * 
+     *        a group of changes committed at once
+     */
+    class kv_batch
+    {
+    public:
+        void put(const std::string& key, const std::string& value);
+
+        void remove(const std::string& key);
+
+        void clear(void);
+
+        bool empty(void) const;
+
+    private:
+        friend class kv;
+
+        // 파일에 그대로 덧붙일 레코드들
+        // records appended to the file as is
+        std::string _records;
+
+        uint32_t _count = 0;
+
+        // 레코드 형식에 맞지 않는 키나 값이 있었는지 여부
+        // whether a key or value did not fit the record format
+        bool _invalid = false;
+    };
+
+    /**
+     * @brief 저장소 통계
+     * 
+     *        store statistics
+     */
+    struct kv_stats {
+        uint32_t keys;
+
+        uint32_t file_bytes;
+
+        // 현재 값을 가진 레코드들의 크기 합
+        // total size of the records holding current values
+        uint32_t live_bytes;
+
+        uint32_t commits;
+
+        uint32_t compactions;
+
+        // 마운트 시 버린 불완전한 묶음의 크기
+        // size of the incomplete batch discarded at mount
+        uint32_t discarded_bytes;
+
+        // 마운트 시 건너뛴 손상된 묶음들의 크기
+        // size of the corrupt batches skipped at mount
+        uint32_t corrupt_bytes;
+    };
+
+    /**
+     * @brief 전원이 끊겨도 안전한 덧붙이기 전용 키 / 값 저장소
+     * 
+     *        모든 변경은 CRC가 붙은 레코드로 파일 끝에 덧붙여지며, 묶음 끝의 커밋 레코드까지 기록된 변경만 유효합니다
+     * 
+     *        마운트 시 파일을 훑어 메모리에 해시 색인을 만들고, 커밋되지 않은 꼬리는 잘라냅니다, 뒤에 유효한 커밋이 있는 손상된 묶음은 건너뜁니다
+     * 
+     *        SD 카드는 재마운트될 수 있으므로 파일은 작업 하나 동안만 SD 카드를 점유한 채 열며, 압축은 잠그지 않은 채 새 파일을 씁니다
+     * 
+     *        stdio만 사용하므로 리눅스 호스트에서 로컬 파일로도 동작합니다(test/kv_test.cpp)
+     * 
+     *        append-only key / value store that survives power loss
+     * 
+     *        every change is appended to the end of the file as a CRC-checked record, and only changes up to a commit record closing their batch are valid
+     * 
+     *        at mount the file is scanned into an in-memory hash index, and the uncommitted tail is cut off, a corrupt batch followed by a valid commit is skipped
+     * 
+     *        the SD card can be remounted, so the file is only opened while holding the SD card for a single operation, and compaction writes the new file without locking
+     * 
+     *        it only uses stdio, so it also works against a local file on a Linux host(test/kv_test.cpp)
+     */
+    class kv
+    {
+    public:
+        kv(void);
+
+        ~kv(void);
+
+        /**
+         * @brief 저장소 파일을 열고 색인을 만듭니다, 파일이 없다면 새로 만듭니다
+         * 
+         *        opens the store file and builds the index, creates the file if there is none
+         * 
+         * @return 저장소 열기 성공 여부
+         * 
+         *         store open success
+         */
+        bool open(const char* path = COFFEE_KV_PATH);
+
+        void close(void);
+
+        /**
+         * @brief 키의 값을 가져옵니다
+         * 
+         *        gets the value of a key
+         * 
+         * @return 키가 있는지 여부
+         * 
+         *         whether the key exists
+         */
+        bool get(const std::string& key, std::string* value);
+
+        bool contains(const std::string& key);
+
+        /**
+         * @brief 값 하나를 기록하고 커밋합니다
+         * 
+         *        writes and commits a single value
+         */
+        bool put(const std::string& key, const std::string& value);
+
+        bool remove(const std::string& key);
+
+        /**
+         * @brief 묶음의 변경들을 한 번의 덧붙이기와 동기화로 커밋합니다, 전원이 끊기면 모두 반영되거나 모두 반영되지 않습니다
+         * 
+         *        commits the changes of a batch with a single append and sync, on power loss either all or none of them apply
+         * 
+         * @return 커밋 성공 여부
+         * 
+         *         commit success
+         */
+        bool commit(kv_batch& batch);
+
+        /**
+         * @brief 현재 값만 새 파일에 옮겨 적어 파일을 압축합니다, 옮겨 적는 동안에도 다른 작업은 막히지 않습니다
+         * 
+         *        compacts the file by copying only the current values to a new file, other operations are not blocked while copying
+         * 
+         * @return 압축 성공 여부, 이미 압축 중이라면 false
+         * 
+         *         compaction success, false if a compaction is already running
+         */
+        bool compact(void);
+
+        void get_stats(kv_stats* stats);
+
+    private:
+        /**
+         * @brief 값의 파일 내 위치
+         * 
+         *        location of a value in the file
+         */
+        struct location {
+            uint32_t offset;
+
+            uint32_t length;
+
+            // 값을 담은 레코드 전체 크기
+            // size of the whole record holding the value
+            uint32_t record_size;
+        };
+
+        std::string _path;
+
+        bool _open;
+
+        // 저장소를 연 SD 카드, get_sd_mounts() 참고
+        // SD card the store was opened on, see get_sd_mounts()
+        uint32_t _cards;
+
+        // 마지막 커밋의 끝, 다음 묶음이 덧붙여질 위치
+        // end of the last commit, where the next batch is appended
+        uint32_t _end;
+
+        std::unordered_map<std::string, location> _index;
+
+        kv_stats _stats;
+
+        std::mutex _mutex;
+
+        std::thread _compactor;
+
+        std::condition_variable _wake;
+
+        bool _compact_pending;
+
+        bool _compacting;
+
+        bool _stopping;
+
+        /**
+         * @brief 파일을 훑어 커밋된 변경들로 색인을 만들고, 잘라낼 커밋되지 않은 꼬리의 크기를 discarded_bytes에 기록합니다
+         * 
+         *        scans the file, builds the index from committed changes and records the size of the uncommitted tail to cut off in discarded_bytes
+         */
+        bool recover(FILE* file);
+
+        /**
+         * @brief 묶음을 파일 끝에 덧붙입니다, SD 카드를 점유한 채 호출해야 합니다
+         * 
+         *        appends a batch to the end of the file, must be called while holding the SD card
+         */
+        bool append(const std::string& data);
+
+        /**
+         * @brief 커밋된 레코드들을 색인에 반영합니다, base는 레코드들의 파일 내 시작 위치입니다
+         * 
+         *        applies committed records to the index, base is where the records start in the file
+         */
+        void apply(const std::string& records, uint32_t base);
+
+        /**
+         * @brief 잠그지 않은 채 스냅샷의 값들을 새 파일에 옮겨 적습니다
+         * 
+         *        copies the values of a snapshot to a new file without locking
+         * 
+         * @param index 새 파일에서의 값 위치들
+         * 
+         *              locations of the values in the new file
+         * 
+         * @param end 새 파일의 끝
+         * 
+         *            end of the new file
+         */
+        bool write_compacted(const std::string& tmp, const std::unordered_map<std::string, location>& snapshot,
+                             std::unordered_map<std::string, location>* index, uint32_t* end);
+
+        /**
+         * @brief 스냅샷 이후 커밋된 묶음들을 새 파일에 옮겨 붙이고 원래 파일과 바꿉니다, 잠근 채 호출해야 합니다
+         * 
+         *        appends the batches committed after the snapshot to the new file and replaces the original with it, must be called while locked
+         */
+        bool swap_compacted(const std::string& tmp, uint32_t snapshot_end, std::unordered_map<std::string, location>& index, uint32_t end);
+
+        /**
+         * @brief 저장소를 연 SD 카드가 아직 마운트되어 있는지 확인합니다, 다른 카드라면 색인이 맞지 않음
+         * 
+         *        checks that the SD card the store was opened on is still mounted, the index does not match a different card
+         */
+        bool same_card(void) const;
+
+        bool should_compact(void) const;
+
+        void compactor_loop(void);
+    };
+}
+#endif
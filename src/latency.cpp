@@ -0,0 +1,367 @@
+#include "latency.hpp"
+
+#include "display.hpp"
+
+namespace coffee
+{
+    enum trace_state {
+        TRACE_IDLE,
+
+        // 표본을 받았고 무효화를 기다리는 중
+        // sample received, waiting for an invalidation
+        TRACE_SAMPLED,
+
+        // 무효화되었고 화면 갱신을 기다리는 중
+        // invalidated, waiting for a refresh
+        TRACE_INVALIDATED,
+
+        // 갱신 중이며 바뀐 영역을 내보내기를 기다리는 중
+        // refreshing, waiting for the changed region to be flushed
+        TRACE_RENDERING,
+
+        // 바뀐 줄이 다음 프레임에 주사되므로 vsync를 기다리는 중
+        // the changed line is scanned in the next frame, waiting for a vsync
+        TRACE_VSYNC,
+
+        TRACE_DONE
+    };
+
+    /**
+     * @brief 추적 중인 상호작용 하나의 시각들
+     * 
+     *        timestamps of the interaction being traced
+     */
+    struct trace {
+        trace_state state;
+
+        int64_t read_start_us;
+
+        int64_t sample_us;
+
+        int64_t refresh_us;
+
+        int64_t flush_us;
+
+        int64_t dma_us;
+
+        // 바뀐 첫 줄이 주사된 시각, 알 수 없으면 0
+        // time the first changed line was scanned, 0 if unknown
+        int64_t photon_us;
+
+        // 표본 이후 무효화된 영역들을 감싸는 영역
+        // area enclosing every area invalidated after the sample
+        lv_area_t dirty;
+
+        // 바뀐 첫 줄
+        // first changed line
+        lv_coord_t row;
+    };
+
+    /**
+     * @brief 갱신 시작 시각을 기록한 뒤 원래의 화면 갱신 타이머를 호출합니다
+     * 
+     *        records when the refresh starts, then calls the original refresh timer
+     */
+    static void traced_refresh(lv_timer_t* timer);
+
+    /**
+     * @brief lvgl이 영역을 무효화할 때 호출되는 rounder_cb, 영역은 바꾸지 않습니다
+     * 
+     *        rounder_cb called when lvgl invalidates an area, it does not change the area
+     */
+    static void trace_invalidate(lv_disp_drv_t* disp_drv, lv_area_t* area);
+
+    /**
+     * @brief 화면에 나타난 추적을 통계에 반영하거나 시간이 초과된 추적을 버립니다
+     * 
+     *        applies a trace that appeared on screen to the statistics, or drops a trace that timed out
+     */
+    static void finish_trace(int64_t now);
+
+    static const char* const stage_names[LATENCY_STAGES + 1] = { "i2c", "queue", "render", "dma", "scanout", "total" };
+
+    static trace current = {};
+
+    // current는 vsync 인터럽트와, stats는 질의하는 태스크와 공유하므로 필요한 잠금
+    // lock needed as current is shared with the vsync interrupt and stats with querying tasks
+    static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    static latency_stats stats = {};
+
+    static int64_t read_start_us = 0;
+
+    static bool last_pressed = false;
+
+    static int last_sample_x = -1;
+
+    static int last_sample_y = -1;
+
+    static lv_timer_cb_t refresh_cb = nullptr;
+
+    // lvgl의 갱신 타이머가 실행 중인지 여부, 갱신과 무효화는 모두 lvgl 태스크에서 일어나므로 잠그지 않음
+    // whether lvgl's refresh timer is running, not locked as refreshing and invalidating both happen in the lvgl task
+    static bool in_refresh = false;
+
+    static void (*prev_rounder)(lv_disp_drv_t* disp_drv, lv_area_t* area) = nullptr;
+
+    void get_latency_stats(latency_stats* stats_)
+    {
+        finish_trace(esp_timer_get_time());
+
+        portENTER_CRITICAL(&trace_lock);
+        *stats_ = stats;
+        portEXIT_CRITICAL(&trace_lock);
+    }
+
+    void reset_latency_stats(void)
+    {
+        portENTER_CRITICAL(&trace_lock);
+        stats = {};
+        portEXIT_CRITICAL(&trace_lock);
+    }
+
+    void print_latency_stats(void)
+    {
+        latency_stats snapshot;
+        get_latency_stats(&snapshot);
+
+        Serial.printf("input latency(%u interactions, %u dropped), average / max:\n", snapshot.interactions, snapshot.dropped);
+
+        if(!snapshot.interactions)
+            return;
+
+        for(int s = 0; s <= LATENCY_STAGES; s++) {
+            const stage_latency& stage = snapshot.stages[s];
+
+            if(stage.samples)
+                Serial.printf("    %-8s %.2f / %.2fms\n", stage_names[s], stage.total_us / 1000.0 / stage.samples, stage.max_us / 1000.0);
+            else
+                Serial.printf("    %-8s n/a\n", stage_names[s]);
+        }
+    }
+
+    void latency_read_start(void)
+    {
+        read_start_us = esp_timer_get_time();
+    }
+
+    void latency_sample(bool pressed, int x, int y)
+    {
+        int64_t now = esp_timer_get_time();
+
+        // 눌린 동안에는 위치가 바뀐 표본, 떼어진 동안에는 상태가 바뀐 표본만 새 입력으로 봄
+        // only a moved sample while pressed, or a state change while released, counts as new input
+        bool changed = pressed != last_pressed || (pressed && (x != last_sample_x || y != last_sample_y));
+
+        last_pressed = pressed;
+        last_sample_x = x;
+        last_sample_y = y;
+
+        finish_trace(now);
+
+        if(!changed)
+            return;
+
+        portENTER_CRITICAL(&trace_lock);
+
+        if(current.state == TRACE_IDLE) {
+            current = {};
+            current.read_start_us = read_start_us;
+            current.sample_us = now;
+            current.state = TRACE_SAMPLED;
+        }
+
+        portEXIT_CRITICAL(&trace_lock);
+    }
+
+    void latency_attach(lv_disp_t* disp)
+    {
+        if(!disp || !disp->refr_timer || refresh_cb)
+            return;
+
+        refresh_cb = disp->refr_timer->timer_cb;
+        disp->refr_timer->timer_cb = traced_refresh;
+
+        prev_rounder = disp->driver->rounder_cb;
+        disp->driver->rounder_cb = trace_invalidate;
+    }
+
+    bool latency_flush_start(const lv_area_t* area)
+    {
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&trace_lock);
+
+        const lv_area_t& dirty = current.dirty;
+
+        bool traced = current.state == TRACE_RENDERING
+                      && !(area->x2 < dirty.x1 || area->x1 > dirty.x2 || area->y2 < dirty.y1 || area->y1 > dirty.y2);
+
+        if(traced) {
+            current.flush_us = now;
+            current.row = max(area->y1, dirty.y1);
+        }
+
+        portEXIT_CRITICAL(&trace_lock);
+
+        return traced;
+    }
+
+    void latency_flush_done(void)
+    {
+        int64_t now = esp_timer_get_time();
+
+        scan_stats scan;
+        get_scan_stats(&scan);
+
+        portENTER_CRITICAL(&trace_lock);
+
+        current.dma_us = now;
+
+        if(!scan.last_vsync_us || !scan.expected_period_us) {
+            // 화면 주사를 감시하지 않으면 주사 단계는 알 수 없음
+            // the scanout stage is unknown without the scanout monitor
+            current.photon_us = 0;
+            current.state = TRACE_DONE;
+        } else {
+            // 패널은 하나의 프레임 버퍼를 계속 주사하므로, 주사선이 아직 바뀐 줄에 닿지 않았다면 이번 프레임에 바로 나타남
+            // the panel keeps scanning a single frame buffer, so the change appears in this frame if the beam has not reached the changed line yet
+            int64_t line_us = scan.last_vsync_us + scan.expected_period_us * (uint32_t) current.row / board::height;
+
+            if(line_us >= now) {
+                current.photon_us = line_us;
+                current.state = TRACE_DONE;
+            } else
+                current.state = TRACE_VSYNC;
+        }
+
+        portEXIT_CRITICAL(&trace_lock);
+    }
+
+    void IRAM_ATTR latency_vsync(int64_t now, uint32_t period_us)
+    {
+        portENTER_CRITICAL_ISR(&trace_lock);
+
+        if(current.state == TRACE_VSYNC) {
+            // 바뀐 줄은 이 프레임에서 vsync로부터 줄 위치만큼 뒤에 주사됨(포치는 무시)
+            // the changed line is scanned this frame, as far after the vsync as its position(porches ignored)
+            current.photon_us = now + period_us * (uint32_t) current.row / board::height;
+            current.state = TRACE_DONE;
+        }
+
+        portEXIT_CRITICAL_ISR(&trace_lock);
+    }
+
+    static void traced_refresh(lv_timer_t* timer)
+    {
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&trace_lock);
+
+        if(current.state == TRACE_INVALIDATED) {
+            current.refresh_us = now;
+            current.state = TRACE_RENDERING;
+        }
+
+        portEXIT_CRITICAL(&trace_lock);
+
+        in_refresh = true;
+
+        refresh_cb(timer);
+
+        in_refresh = false;
+    }
+
+    static void trace_invalidate(lv_disp_drv_t* disp_drv, lv_area_t* area)
+    {
+        // 응용 프로그램의 rounder_cb가 바꾼 영역을 기록함
+        // records the area as changed by the application's rounder_cb
+        if(prev_rounder)
+            prev_rounder(disp_drv, area);
+
+        // 갱신 중에는 lvgl이 한 번에 그릴 줄 수를 정하는 데에도 rounder_cb를 호출하므로 무시
+        // lvgl also calls rounder_cb while refreshing to decide how many lines to draw at once, so those are ignored
+        if(in_refresh)
+            return;
+
+        portENTER_CRITICAL(&trace_lock);
+
+        if(current.state == TRACE_SAMPLED) {
+            current.dirty = *area;
+            current.state = TRACE_INVALIDATED;
+        } else if(current.state == TRACE_INVALIDATED) {
+            current.dirty.x1 = min(current.dirty.x1, area->x1);
+            current.dirty.y1 = min(current.dirty.y1, area->y1);
+            current.dirty.x2 = max(current.dirty.x2, area->x2);
+            current.dirty.y2 = max(current.dirty.y2, area->y2);
+        }
+
+        portEXIT_CRITICAL(&trace_lock);
+    }
+
+    static void finish_trace(int64_t now)
+    {
+        uint32_t stages[LATENCY_STAGES + 1] = {};
+
+        portENTER_CRITICAL(&trace_lock);
+
+        trace done = current;
+
+        bool timed_out = current.state != TRACE_IDLE && current.state != TRACE_DONE
+                         && now - current.sample_us > COFFEE_LATENCY_TIMEOUT_MS * 1000LL;
+
+        if(current.state == TRACE_DONE || timed_out)
+            current.state = TRACE_IDLE;
+
+        bool finished = !timed_out && done.state == TRACE_DONE;
+
+        // 화면 주사를 감시하지 않았다면 주사 단계는 알 수 없으므로 세지도, 합에 더하지도 않음
+        // the scanout stage is unknown without the scanout monitor, so it is neither counted nor added to the sum
+        bool scanned = done.photon_us != 0;
+
+        if(timed_out)
+            stats.dropped++;
+        else if(finished) {
+            stages[LATENCY_I2C] = done.sample_us - done.read_start_us;
+            stages[LATENCY_QUEUE] = done.refresh_us - done.sample_us;
+            stages[LATENCY_RENDER] = done.flush_us - done.refresh_us;
+            stages[LATENCY_DMA] = done.dma_us - done.flush_us;
+            stages[LATENCY_SCANOUT] = scanned ? done.photon_us - done.dma_us : 0;
+
+            for(int s = 0; s < LATENCY_STAGES; s++)
+                stages[LATENCY_STAGES] += stages[s];
+
+            stats.interactions++;
+
+            for(int s = 0; s <= LATENCY_STAGES; s++) {
+                if(s == LATENCY_SCANOUT && !scanned)
+                    continue;
+
+                stage_latency& stage = stats.stages[s];
+
+                stage.samples++;
+                stage.last_us = stages[s];
+                stage.total_us += stages[s];
+
+                if(stages[s] > stage.max_us)
+                    stage.max_us = stages[s];
+            }
+        }
+
+        portEXIT_CRITICAL(&trace_lock);
+
+#if COFFEE_PRINT_LATENCY
+        if(!finished)
+            return;
+
+        char scanout[16] = "n/a";
+
+        if(scanned)
+            snprintf(scanout, sizeof(scanout), "%.2f", stages[LATENCY_SCANOUT] / 1000.0);
+
+        Serial.printf("input latency: %.2fms(i2c %.2f, queue %.2f, render %.2f, dma %.2f, scanout %s)\n",
+                      stages[LATENCY_STAGES] / 1000.0, stages[LATENCY_I2C] / 1000.0, stages[LATENCY_QUEUE] / 1000.0,
+                      stages[LATENCY_RENDER] / 1000.0, stages[LATENCY_DMA] / 1000.0, scanout);
+#endif
+    }
+}
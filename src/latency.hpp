@@ -0,0 +1,174 @@
+#ifndef COFFEE_LATENCY_HPP
+#define COFFEE_LATENCY_HPP
+
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+
+#include <Arduino.h>
+
+#include <lvgl.h>
+
+/**
+ * @def COFFEE_LATENCY_TRACE
+ * 
+ * @brief 터치 입력이 화면에 나타나기까지의 지연을 단계별로 측정하려면 이 값을 1로 설정합니다
+ * 
+ *        측정 중에는 추적되는 영역을 내보낼 때마다 DMA가 끝날 때까지 기다리므로, 평소에는 0으로 두세요
+ * 
+ *        set this value to 1 to measure the latency from a touch input to its appearance on screen, stage by stage
+ * 
+ *        while tracing, flushing a traced region waits for its DMA to finish, so leave it at 0 normally
+ */
+#define COFFEE_LATENCY_TRACE 0
+
+/**
+ * @def COFFEE_PRINT_LATENCY
+ * 
+ * @brief 추적 중 상호작용이 화면에 나타날 때마다 단계별 지연을 출력하려면 이 값을 1로 설정합니다
+ * 
+ *        set this value to 1 to print the per-stage latency whenever a traced interaction appears on screen
+ */
+#define COFFEE_PRINT_LATENCY 0
+
+/**
+ * @def COFFEE_LATENCY_TIMEOUT_MS
+ * 
+ * @brief 이 시간 안에 화면에 나타나지 않은 상호작용은 버립니다
+ * 
+ *        interactions not appearing on screen within this time are dropped
+ */
+#define COFFEE_LATENCY_TIMEOUT_MS 500
+
+namespace coffee
+{
+    enum latency_stage {
+        // GT911에서 터치 지점을 읽는 시간
+        // time reading the touch points from the GT911
+        LATENCY_I2C,
+
+        // 입력 처리와 이벤트 콜백, 화면 갱신 타이머를 기다리는 시간
+        // time for input processing, event callbacks and waiting for the refresh timer
+        LATENCY_QUEUE,
+
+        // 화면 갱신 시작부터 바뀐 영역을 내보내기 시작할 때까지의 시간
+        // time from the start of the refresh until the changed region starts being flushed
+        LATENCY_RENDER,
+
+        // 바뀐 영역을 프레임 버퍼로 옮기는 시간
+        // time moving the changed region into the frame buffer
+        LATENCY_DMA,
+
+        // 패널이 바뀐 첫 줄을 주사할 때까지의 시간, 화면 주사 감시가 켜져 있을 때만 측정됨
+        // time until the panel scans the first changed line, only measured while the scanout monitor is running
+        LATENCY_SCANOUT,
+
+        // 질의 시 모든 단계의 합, 주사 단계는 측정되었을 때만 포함됨
+        // sum of every stage when querying, the scanout stage is only included when measured
+        LATENCY_STAGES
+    };
+
+    /**
+     * @brief 한 단계의 지연 통계
+     * 
+     *        latency statistics of a single stage
+     */
+    struct stage_latency {
+        // 측정된 상호작용 수, 주사 단계는 화면 주사 감시가 꺼져 있으면 세지 않음
+        // number of interactions measured, the scanout stage is not counted while the scanout monitor is off
+        uint32_t samples;
+
+        uint32_t last_us;
+
+        uint32_t max_us;
+
+        uint64_t total_us;
+    };
+
+    /**
+     * @brief 상호작용 추적 통계
+     * 
+     *        statistics of interaction tracing
+     */
+    struct latency_stats {
+        // 화면에 나타날 때까지 추적된 상호작용 수
+        // number of interactions traced until they appeared on screen
+        uint32_t interactions;
+
+        // 화면을 바꾸지 않았거나 시간 초과로 버린 상호작용 수
+        // number of interactions dropped for not changing the screen or timing out
+        uint32_t dropped;
+
+        stage_latency stages[LATENCY_STAGES + 1];
+    };
+
+    /**
+     * @brief 추적 통계를 가져옵니다
+     * 
+     *        gets the tracing statistics
+     */
+    void get_latency_stats(latency_stats* stats);
+
+    void reset_latency_stats(void);
+
+    /**
+     * @brief 단계별 평균 및 최대 지연을 출력합니다
+     * 
+     *        prints the average and maximum latency of each stage
+     */
+    void print_latency_stats(void);
+
+    /**
+     * @brief 터치 지점을 읽기 직전에 호출됩니다
+     * 
+     *        called right before reading the touch points
+     */
+    void latency_read_start(void);
+
+    /**
+     * @brief 터치 지점을 읽은 직후 호출되며, 이전 표본과 다르면 새 상호작용 추적을 시작합니다
+     * 
+     *        한 번에 하나의 상호작용만 추적하므로, 추적 중 들어온 표본은 무시됩니다
+     * 
+     *        called right after reading the touch points, starts tracing a new interaction if it differs from the previous sample
+     * 
+     *        only one interaction is traced at a time, so samples arriving while tracing are ignored
+     */
+    void latency_sample(bool pressed, int x, int y);
+
+    /**
+     * @brief 디스플레이의 화면 갱신 타이머에 갱신 시작 시각을 기록하는 함수를 끼워 넣고, 무효화를 감지하도록 rounder_cb를 설정합니다
+     * 
+     *        응용 프로그램이 설정한 rounder_cb가 있다면 먼저 호출됩니다
+     * 
+     *        wraps the refresh timer of the display with a function recording when each refresh starts, and sets rounder_cb to catch invalidations
+     * 
+     *        a rounder_cb set by the application is still called first
+     */
+    void latency_attach(lv_disp_t* disp);
+
+    /**
+     * @brief 영역을 내보내기 직전에 호출됩니다
+     * 
+     *        called right before flushing a region
+     * 
+     * @return 추적 중인 변경이 영역에 있어 DMA 완료를 기다린 뒤 latency_flush_done()을 호출해야 하는지 여부
+     * 
+     *         whether the region holds the traced change, so latency_flush_done() must be called after waiting for the DMA
+     */
+    bool latency_flush_start(const lv_area_t* area);
+
+    void latency_flush_done(void);
+
+    /**
+     * @brief vsync 인터럽트에서 호출됩니다
+     * 
+     *        called from the vsync interrupt
+     * 
+     * @param period_us 예상 프레임 주기
+     * 
+     *                  expected frame period
+     */
+    void IRAM_ATTR latency_vsync(int64_t now, uint32_t period_us);
+}
+#endif
@@ -0,0 +1,418 @@
+#include "lv_alloc.h"
+
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <multi_heap.h>
+
+#include <freertos/FreeRTOS.h>
+
+#include <Arduino.h>
+
+#include "mem.hpp"
+
+namespace coffee
+{
+    /**
+     * @brief 내부 SRAM에 놓이는 고정 크기 블록 풀
+     * 
+     *        fixed-size block pool placed in internal SRAM
+     */
+    struct lv_pool {
+        uint8_t* base;
+
+        size_t block_size;
+
+        size_t blocks;
+
+        // 비어 있는 블록들은 첫 워드에 다음 빈 블록의 주소를 저장합니다
+        // free blocks store the address of the next free block in their first word
+        void* free_list;
+
+        // 블록마다 실제로 요청된 크기
+        // size actually requested for each block
+        uint16_t* requested;
+
+        size_t used_blocks;
+
+        size_t peak_blocks;
+
+        // 크기 등급이 가득 차 PSRAM 영역으로 넘어간 요청 수
+        // number of requests passed on to the PSRAM arena because the class was full
+        uint32_t spills;
+    };
+
+    /**
+     * @brief 요청 크기를 담을 수 있는 가장 작은 크기 등급을 찾습니다
+     * 
+     *        finds the smallest size class that can hold the requested size
+     * 
+     * @return 크기 등급 번호, 풀로 처리하기에 너무 크면 -1
+     * 
+     *         index of the size class, or -1 if too large for the pools
+     */
+    static int size_class(size_t size);
+
+    /**
+     * @brief 포인터가 속한 풀을 찾습니다
+     * 
+     *        finds the pool the pointer belongs to
+     * 
+     * @return 포인터를 소유한 풀, 영역에서 할당되었으면 nullptr
+     * 
+     *         pool owning the pointer, or nullptr if it came from the arena
+     */
+    static lv_pool* owner_pool(const void* ptr);
+
+    static void* pool_alloc(lv_pool& pool, size_t size);
+
+    static void pool_free(lv_pool& pool, void* ptr);
+
+    /**
+     * @brief 초기화 도중 실패했을 때 이미 할당된 풀과 영역을 해제합니다
+     * 
+     *        frees the pools and arena already allocated when initialization fails midway
+     */
+    static void release_lv_mem(void);
+
+    static lv_pool pools[COFFEE_LV_POOL_CLASSES];
+
+    // 큰 할당을 위한 PSRAM 영역
+    // PSRAM arena for large allocations
+    static multi_heap_handle_t arena = nullptr;
+
+    static void* arena_base = nullptr;
+
+    // lvgl 밖의 태스크(동영상 재생 등)도 할당하므로 영역에도 잠금이 필요
+    // tasks outside lvgl(video playback and so on) allocate too, so the arena needs a lock as well
+    static portMUX_TYPE arena_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    static size_t pool_used = 0;
+
+    static size_t pool_requested = 0;
+
+    static size_t pool_peak = 0;
+
+    static uint32_t pool_allocs = 0;
+
+    static uint32_t arena_allocs = 0;
+
+    static uint32_t arena_failures = 0;
+
+    static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    static bool initialized = false;
+
+    bool init_lv_mem(void)
+    {
+        static const size_t blocks[COFFEE_LV_POOL_CLASSES] = COFFEE_LV_POOL_BLOCKS;
+
+        if(initialized)
+            return true;
+
+        size_t block_size = COFFEE_LV_POOL_MIN_SIZE;
+
+        for(int i = 0; i < COFFEE_LV_POOL_CLASSES; i++, block_size <<= 1) {
+            lv_pool& pool = pools[i];
+
+            pool.block_size = block_size;
+            pool.blocks = blocks[i];
+
+            pool.base = (uint8_t*) mem_aligned_alloc(8, block_size * blocks[i], MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MEM_LVGL);
+            pool.requested = (uint16_t*) mem_calloc(blocks[i], sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MEM_LVGL);
+            if(!pool.base || !pool.requested) {
+                Serial.printf("error: failed to allocate lvgl memory pool(%uB)\n", block_size);
+
+                release_lv_mem();
+
+                return false;
+            }
+
+            pool.free_list = nullptr;
+
+            for(size_t j = blocks[i]; j > 0; j--) {
+                void* block = pool.base + (j - 1) * block_size;
+
+                *(void**) block = pool.free_list;
+                pool.free_list = block;
+            }
+        }
+
+        arena_base = mem_alloc(COFFEE_LV_ARENA_SIZE, MALLOC_CAP_SPIRAM, MEM_LVGL);
+        if(!arena_base) {
+            Serial.println("error: failed to allocate lvgl memory arena");
+
+            release_lv_mem();
+
+            return false;
+        }
+
+        arena = multi_heap_register(arena_base, COFFEE_LV_ARENA_SIZE);
+        if(!arena) {
+            Serial.println("error: failed to register lvgl memory arena");
+
+            release_lv_mem();
+
+            return false;
+        }
+
+        multi_heap_set_lock(arena, &arena_lock);
+
+        initialized = true;
+
+        return true;
+    }
+
+    void get_lv_mem_stats(lv_mem_tier tier, lv_mem_stats* stats)
+    {
+        memset(stats, 0, sizeof(lv_mem_stats));
+
+        if(!initialized)
+            return;
+
+        if(tier == LV_MEM_TIER_POOL) {
+            for(const lv_pool& pool: pools)
+                stats->capacity += pool.block_size * pool.blocks;
+
+            portENTER_CRITICAL(&lock);
+
+            stats->used = pool_used;
+            stats->requested = pool_requested;
+            stats->peak = pool_peak;
+            stats->allocs = pool_allocs;
+
+            for(const lv_pool& pool: pools)
+                stats->failures += pool.spills;
+
+            portEXIT_CRITICAL(&lock);
+
+            stats->frag_pct = stats->used ? 100 - stats->requested * 100 / stats->used : 0;
+        } else {
+            multi_heap_info_t info;
+            multi_heap_get_info(arena, &info);
+
+            stats->capacity = info.total_free_bytes + info.total_allocated_bytes;
+            stats->used = info.total_allocated_bytes;
+            stats->requested = info.total_allocated_bytes;
+            stats->peak = stats->capacity - info.minimum_free_bytes;
+
+            portENTER_CRITICAL(&lock);
+
+            stats->allocs = arena_allocs;
+            stats->failures = arena_failures;
+
+            portEXIT_CRITICAL(&lock);
+
+            stats->frag_pct = info.total_free_bytes ? 100 - info.largest_free_block * 100 / info.total_free_bytes : 0;
+        }
+    }
+
+    void print_lv_mem_stats(void)
+    {
+        static const char* names[] = { "pool(SRAM)", "arena(PSRAM)" };
+
+        for(int tier = LV_MEM_TIER_POOL; tier <= LV_MEM_TIER_ARENA; tier++) {
+            lv_mem_stats stats;
+            get_lv_mem_stats((lv_mem_tier) tier, &stats);
+
+            Serial.printf("lvgl %s: %u/%uB used, peak %uB, %d%% fragmented, %u allocs, %u failures\n",
+                          names[tier], stats.used, stats.capacity, stats.peak, stats.frag_pct, stats.allocs, stats.failures);
+        }
+
+        for(const lv_pool& pool: pools)
+            Serial.printf("%*s%uB: %u/%u blocks, peak %u, spills %u\n", 4, "", pool.block_size, pool.used_blocks, pool.blocks, pool.peak_blocks, pool.spills);
+    }
+
+    static int size_class(size_t size)
+    {
+        size_t block_size = COFFEE_LV_POOL_MIN_SIZE;
+
+        for(int i = 0; i < COFFEE_LV_POOL_CLASSES; i++, block_size <<= 1)
+            if(size <= block_size)
+                return i;
+
+        return -1;
+    }
+
+    static lv_pool* owner_pool(const void* ptr)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(ptr);
+
+        for(lv_pool& pool: pools)
+            if(p >= pool.base && p < pool.base + pool.block_size * pool.blocks)
+                return &pool;
+
+        return nullptr;
+    }
+
+    static void* pool_alloc(lv_pool& pool, size_t size)
+    {
+        portENTER_CRITICAL(&lock);
+
+        void* block = pool.free_list;
+
+        if(block) {
+            pool.free_list = *(void**) block;
+
+            pool.requested[(static_cast<uint8_t*>(block) - pool.base) / pool.block_size] = size;
+
+            if(++pool.used_blocks > pool.peak_blocks)
+                pool.peak_blocks = pool.used_blocks;
+
+            pool_used += pool.block_size;
+            pool_requested += size;
+            pool_allocs++;
+
+            if(pool_used > pool_peak)
+                pool_peak = pool_used;
+        } else
+            pool.spills++;
+
+        portEXIT_CRITICAL(&lock);
+
+        return block;
+    }
+
+    static void pool_free(lv_pool& pool, void* ptr)
+    {
+        portENTER_CRITICAL(&lock);
+
+        pool_used -= pool.block_size;
+        pool_requested -= pool.requested[(static_cast<uint8_t*>(ptr) - pool.base) / pool.block_size];
+        pool.used_blocks--;
+
+        *(void**) ptr = pool.free_list;
+        pool.free_list = ptr;
+
+        portEXIT_CRITICAL(&lock);
+    }
+
+    static void release_lv_mem(void)
+    {
+        for(lv_pool& pool: pools) {
+            mem_free(pool.base);
+            mem_free(pool.requested);
+
+            pool = {};
+        }
+
+        mem_free(arena_base);
+
+        arena_base = nullptr;
+        arena = nullptr;
+    }
+}
+
+using namespace coffee;
+
+void* coffee_lv_malloc(size_t size)
+{
+    // init_lcd()가 lv_init() 전에 init_lv_mem()을 한 번 호출하므로 여기서 초기화하지 않음
+    // init_lcd() calls init_lv_mem() once before lv_init(), so this does not initialize
+    if(!initialized)
+        return nullptr;
+
+    if(size == 0)
+        size = 1;
+
+    int cls = size_class(size);
+    if(cls >= 0) {
+        void* block = pool_alloc(pools[cls], size);
+        if(block)
+            return block;
+    }
+
+    void* block = multi_heap_malloc(arena, size);
+
+    portENTER_CRITICAL(&lock);
+
+    if(block)
+        arena_allocs++;
+    else
+        arena_failures++;
+
+    portEXIT_CRITICAL(&lock);
+
+    return block;
+}
+
+void coffee_lv_free(void* ptr)
+{
+    if(!ptr)
+        return;
+
+    lv_pool* pool = owner_pool(ptr);
+
+    if(pool)
+        pool_free(*pool, ptr);
+    else
+        multi_heap_free(arena, ptr);
+}
+
+void* coffee_lv_realloc(void* ptr, size_t new_size)
+{
+    if(!ptr)
+        return coffee_lv_malloc(new_size);
+
+    if(new_size == 0) {
+        coffee_lv_free(ptr);
+
+        return nullptr;
+    }
+
+    size_t old_size;
+
+    int cls = size_class(new_size);
+
+    lv_pool* pool = owner_pool(ptr);
+
+    if(pool) {
+        // 같은 크기 등급에 그대로 들어가면 블록을 유지
+        // keep the block if the new size still falls into the same size class
+        if(cls >= 0 && &pools[cls] == pool) {
+            portENTER_CRITICAL(&lock);
+
+            uint16_t& requested = pool->requested[(static_cast<uint8_t*>(ptr) - pool->base) / pool->block_size];
+
+            pool_requested += new_size;
+            pool_requested -= requested;
+            requested = new_size;
+            pool_allocs++;
+
+            portEXIT_CRITICAL(&lock);
+
+            return ptr;
+        }
+
+        old_size = pool->requested[(static_cast<uint8_t*>(ptr) - pool->base) / pool->block_size];
+    } else {
+        if(cls < 0) {
+            void* block = multi_heap_realloc(arena, ptr, new_size);
+
+            portENTER_CRITICAL(&lock);
+
+            if(block)
+                arena_allocs++;
+            else
+                arena_failures++;
+
+            portEXIT_CRITICAL(&lock);
+
+            return block;
+        }
+
+        old_size = multi_heap_get_allocated_size(arena, ptr);
+    }
+
+    // 계층 또는 크기 등급이 바뀌면 새 블록으로 옮김
+    // move to a new block when the tier or size class changes
+    void* block = coffee_lv_malloc(new_size);
+    if(!block)
+        return nullptr;
+
+    memcpy(block, ptr, old_size < new_size ? old_size : new_size);
+
+    coffee_lv_free(ptr);
+
+    return block;
+}
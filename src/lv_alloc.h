@@ -0,0 +1,138 @@
+#ifndef COFFEE_LV_ALLOC_H
+#define COFFEE_LV_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def COFFEE_LV_POOL_CLASSES
+ * 
+ * @brief 내부 SRAM 풀의 크기 등급 수입니다(16B ~ 2KB)
+ * 
+ *        800px 폭 화면에서 lv_mem_buf_get()이 요청하는 줄 단위 임시 그리기 버퍼(마스크 800B, 색상 1600B)도 풀에서 처리하도록 2KB까지 둡니다, 더 큰 요청은 PSRAM 영역으로 넘어가 그릴 때마다 PSRAM에 접근합니다
+ * 
+ *        number of size classes in the internal SRAM pools(16B ~ 2KB)
+ * 
+ *        goes up to 2KB so the per-line temporary draw buffers lv_mem_buf_get() requests on an 800px wide screen(800B masks, 1600B colors) are served from the pools too, larger requests go to the PSRAM arena and touch PSRAM on every draw
+ */
+#define COFFEE_LV_POOL_CLASSES 8
+
+#define COFFEE_LV_POOL_MIN_SIZE 16
+
+/**
+ * @def COFFEE_LV_POOL_BLOCKS
+ * 
+ * @brief 각 크기 등급별 블록 수입니다
+ * 
+ *        기본값은 기존 lvgl 내장 메모리(32KB)에 임시 그리기 버퍼용 20KB를 더한 52KB의 내부 메모리를 사용합니다
+ * 
+ *        number of blocks for each size class
+ * 
+ *        the default uses 52KB of internal memory, the former built-in lvgl pool(32KB) plus 20KB for temporary draw buffers
+ */
+#define COFFEE_LV_POOL_BLOCKS { 256, 256, 128, 64, 16, 8, 8, 4 }
+
+/**
+ * @def COFFEE_LV_ARENA_SIZE
+ * 
+ * @brief 큰 할당을 처리하는 PSRAM 영역의 크기입니다
+ * 
+ *        size of the PSRAM arena serving large allocations
+ */
+#define COFFEE_LV_ARENA_SIZE (1024 * 1024)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * lvgl의 LV_MEM_CUSTOM_ALLOC / FREE / REALLOC으로 연결되는 함수들입니다
+ * 
+ * functions wired to lvgl's LV_MEM_CUSTOM_ALLOC / FREE / REALLOC
+ */
+void* coffee_lv_malloc(size_t size);
+
+void coffee_lv_free(void* ptr);
+
+void* coffee_lv_realloc(void* ptr, size_t new_size);
+
+#ifdef __cplusplus
+}
+
+namespace coffee
+{
+    enum lv_mem_tier {
+        LV_MEM_TIER_POOL,
+        LV_MEM_TIER_ARENA
+    };
+
+    /**
+     * @brief 할당 계층별 사용량 통계
+     * 
+     *        usage statistics of an allocation tier
+     */
+    struct lv_mem_stats {
+        // 계층 전체 크기
+        // total size of the tier
+        size_t capacity;
+
+        // 현재 할당된 블록 크기의 합
+        // sum of the currently allocated block sizes
+        size_t used;
+
+        // 현재 실제로 요청된 크기의 합
+        // sum of the currently requested sizes
+        size_t requested;
+
+        // 최대 사용량
+        // high-water mark of used
+        size_t peak;
+
+        uint32_t allocs;
+
+        uint32_t failures;
+
+        // 풀: 크기 등급 반올림으로 낭비된 비율, 영역: 1 - 최대 연속 여유 공간 / 전체 여유 공간
+        // pool: share lost to size class rounding, arena: 1 - largest free block / total free
+        uint8_t frag_pct;
+    };
+
+    /**
+     * @brief lvgl 메모리 할당자를 초기화합니다
+     * 
+     *        내부 SRAM에 크기 등급별 풀을, PSRAM에 큰 할당을 위한 영역을 만듭니다
+     * 
+     *        initializes the lvgl memory allocator
+     * 
+     *        creates the size class pools in internal SRAM and the arena for large allocations in PSRAM
+     * 
+     * @return 할당자 초기화 성공 여부
+     * 
+     *         allocator initialization success
+     */
+    bool init_lv_mem(void);
+
+    /**
+     * @brief 할당 계층의 사용량 통계를 가져옵니다
+     * 
+     *        gets the usage statistics of an allocation tier
+     * 
+     * @param tier 통계를 가져올 계층
+     * 
+     *             tier to get the statistics of
+     * 
+     * @param stats 통계가 저장될 구조체
+     * 
+     *              structure to store the statistics
+     */
+    void get_lv_mem_stats(lv_mem_tier tier, lv_mem_stats* stats);
+
+    /**
+     * @brief 각 계층 및 크기 등급별 사용량을 출력합니다
+     * 
+     *        prints the usage of each tier and size class
+     */
+    void print_lv_mem_stats(void);
+}
+#endif
+#endif
@@ -0,0 +1,318 @@
+#include "mem.hpp"
+
+#include "lv_alloc.h"
+
+// 추적되는 블록임을 나타내는 값, 해제 시 지워서 이중 해제를 잡아냄
+// value marking a tracked block, cleared on free to catch double frees
+#define MEM_MAGIC 0xC0FFEE42
+
+namespace coffee
+{
+    /**
+     * @brief 추적되는 블록 앞에 붙는 헤더
+     * 
+     *        header placed in front of a tracked block
+     */
+    struct mem_header {
+        uint32_t magic;
+
+        uint32_t size;
+
+        // 할당된 블록의 시작부터 사용자 영역까지의 거리
+        // distance from the start of the allocated block to the user area
+        uint16_t offset;
+
+        uint8_t subsystem;
+
+        uint8_t region;
+
+        uint32_t reserved;
+    };
+
+    /**
+     * @brief 블록을 할당하고 헤더를 붙입니다
+     * 
+     *        allocates a block and attaches the header
+     */
+    static void* alloc_tagged(size_t alignment, size_t size, uint32_t caps, mem_subsystem subsystem);
+
+    /**
+     * @brief 할당 또는 해제 하나를 관련된 모든 사용량에 반영합니다
+     * 
+     *        applies a single allocation or free to every related usage
+     */
+    static void account(mem_subsystem subsystem, mem_region region, size_t size, bool alloc);
+
+    static const char* const subsystem_names[MEM_SUBSYSTEMS + 1] = {
+        "display", "sd", "assets", "lvgl", "video", "app", "total"
+    };
+
+    static const char* const region_names[MEM_REGIONS] = { "DMA", "internal", "PSRAM" };
+
+    // 각 영역의 여유 공간을 확인할 때 사용하는 MALLOC_CAP_* 조합
+    // MALLOC_CAP_* combinations used to check the free space of each region
+    static const uint32_t region_caps[MEM_REGIONS] = {
+        MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL,
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+        MALLOC_CAP_SPIRAM
+    };
+
+    // 마지막 행과 열은 각각 모든 서브시스템, 모든 영역의 합
+    // the last row and column are the sums over every subsystem and every region
+    static mem_usage usage[MEM_SUBSYSTEMS + 1][MEM_REGIONS + 1];
+
+    static portMUX_TYPE usage_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    static TaskHandle_t report_task = nullptr;
+
+    // 주기적 보고가 확인하는 앞으로 할당할 DMA 메모리, usage_lock으로 보호됨
+    // DMA memory still to be allocated that the periodic report checks, protected by usage_lock
+    static size_t report_dma_needed = 0;
+
+    void* mem_alloc(size_t size, uint32_t caps, mem_subsystem subsystem)
+    {
+        return alloc_tagged(0, size, caps, subsystem);
+    }
+
+    void* mem_calloc(size_t n, size_t size, uint32_t caps, mem_subsystem subsystem)
+    {
+        if(size && n > SIZE_MAX / size)
+            return nullptr;
+
+        void* ptr = alloc_tagged(0, n * size, caps, subsystem);
+        if(ptr)
+            memset(ptr, 0, n * size);
+
+        return ptr;
+    }
+
+    void* mem_aligned_alloc(size_t alignment, size_t size, uint32_t caps, mem_subsystem subsystem)
+    {
+        return alloc_tagged(alignment, size, caps, subsystem);
+    }
+
+    void mem_free(void* ptr)
+    {
+        if(!ptr)
+            return;
+
+        mem_header* header = (mem_header*) ptr - 1;
+
+        if(header->magic != MEM_MAGIC) {
+            Serial.printf("error: mem_free() on an untracked or already freed block(%p)\n", ptr);
+
+            return;
+        }
+
+        header->magic = 0;
+
+        account((mem_subsystem) header->subsystem, (mem_region) header->region, header->size, false);
+
+        heap_caps_free((uint8_t*) ptr - header->offset);
+    }
+
+    void get_mem_usage(mem_subsystem subsystem, mem_region region, mem_usage* usage_)
+    {
+        portENTER_CRITICAL(&usage_lock);
+        *usage_ = usage[subsystem][region];
+        portEXIT_CRITICAL(&usage_lock);
+    }
+
+    void print_mem_usage(void)
+    {
+        mem_usage snapshot[MEM_SUBSYSTEMS + 1][MEM_REGIONS + 1];
+
+        portENTER_CRITICAL(&usage_lock);
+        memcpy(snapshot, usage, sizeof(snapshot));
+        portEXIT_CRITICAL(&usage_lock);
+
+        Serial.println("tracked memory(current / peak, blocks):");
+
+        for(int s = 0; s <= MEM_SUBSYSTEMS; s++) {
+            if(!snapshot[s][MEM_REGIONS].allocs && s != MEM_SUBSYSTEMS)
+                continue;
+
+            Serial.printf("    %-8s", subsystem_names[s]);
+
+            for(int r = 0; r < MEM_REGIONS; r++) {
+                const mem_usage& u = snapshot[s][r];
+
+                Serial.printf(" %s %u / %uB, %u", region_names[r], u.current, u.peak, u.count);
+
+                if(u.failures)
+                    Serial.printf("(%u failed)", u.failures);
+
+                Serial.print(r < MEM_REGIONS - 1 ? " |" : "\n");
+            }
+        }
+
+        Serial.println("heap(free / minimum free / largest block):");
+
+        for(int r = 0; r < MEM_REGIONS; r++)
+            Serial.printf("    %-8s %u / %u / %uB\n", region_names[r], heap_caps_get_free_size(region_caps[r]),
+                          heap_caps_get_minimum_free_size(region_caps[r]), heap_caps_get_largest_free_block(region_caps[r]));
+
+        // lvgl 객체는 lvgl 할당자 안에서 따로 집계됨
+        // lvgl objects are counted separately inside the lvgl allocator
+        lv_mem_stats pool, arena;
+        get_lv_mem_stats(LV_MEM_TIER_POOL, &pool);
+        get_lv_mem_stats(LV_MEM_TIER_ARENA, &arena);
+
+        Serial.printf("lvgl objects: pool %u / %uB, arena %u / %uB(peak %u / %uB)\n",
+                      pool.used, pool.capacity, arena.used, arena.capacity, pool.peak, arena.peak);
+    }
+
+    bool start_mem_report(uint32_t period_ms, size_t dma_needed)
+    {
+        if(report_task || !period_ms)
+            return false;
+
+        portENTER_CRITICAL(&usage_lock);
+        report_dma_needed = dma_needed;
+        portEXIT_CRITICAL(&usage_lock);
+
+        auto loop = [](void* arg) {
+            uint32_t period_ms = (uint32_t) (uintptr_t) arg;
+
+            // 알림은 stop_mem_report()만 보내므로, 알림을 받을 때까지 살아 있음
+            // only stop_mem_report() sends a notification, so the task stays alive until it receives one
+            do {
+                print_mem_usage();
+
+                portENTER_CRITICAL(&usage_lock);
+                size_t needed = report_dma_needed;
+                portEXIT_CRITICAL(&usage_lock);
+
+                check_dma_headroom(needed);
+            } while(!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(period_ms)));
+
+            vTaskDelete(nullptr);
+        };
+
+        // 태스크가 실행되기 전에 report_task가 정해짐
+        // report_task is set before the task runs
+        if(xTaskCreate(loop, "mem_report", COFFEE_MEM_REPORT_STACK, (void*) (uintptr_t) period_ms, 1, &report_task) != pdPASS) {
+            Serial.println("error: failed to start memory report");
+
+            report_task = nullptr;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void stop_mem_report(void)
+    {
+        TaskHandle_t task = report_task;
+        if(!task)
+            return;
+
+        report_task = nullptr;
+
+        xTaskNotifyGive(task);
+    }
+
+    bool check_dma_headroom(size_t needed)
+    {
+        // 화면 버퍼 등은 한 덩어리로 할당되므로 최대 연속 블록에 들어가야 함
+        // the screen buffer and the like are allocated in one piece, so they must fit in the largest free block
+        size_t largest = heap_caps_get_largest_free_block(region_caps[MEM_DMA]);
+
+        if(largest >= needed + COFFEE_MEM_DMA_HEADROOM)
+            return true;
+
+        Serial.printf("warning: DMA memory is short, largest free block %uB is below %uB still needed plus %uB of headroom\n",
+                      largest, needed, COFFEE_MEM_DMA_HEADROOM);
+
+        return false;
+    }
+
+    static void* alloc_tagged(size_t alignment, size_t size, uint32_t caps, mem_subsystem subsystem)
+    {
+        // 헤더 뒤의 사용자 영역도 요청된 단위로 정렬되도록 함
+        // keeps the user area after the header aligned to the requested boundary too
+        size_t offset = (alignment > sizeof(mem_header)) ? alignment : sizeof(mem_header);
+
+        uint8_t* base = (uint8_t*) (alignment ? heap_caps_aligned_alloc(alignment, size + offset, caps)
+                                              : heap_caps_malloc(size + offset, caps));
+
+        mem_region region;
+
+        if(caps & MALLOC_CAP_DMA)
+            region = MEM_DMA;
+        else if(base ? esp_ptr_external_ram(base) : (caps & MALLOC_CAP_SPIRAM))
+            region = MEM_PSRAM;
+        else
+            region = MEM_INTERNAL;
+
+        if(!base) {
+            portENTER_CRITICAL(&usage_lock);
+
+            usage[subsystem][region].failures++;
+            usage[subsystem][MEM_REGIONS].failures++;
+            usage[MEM_SUBSYSTEMS][region].failures++;
+            usage[MEM_SUBSYSTEMS][MEM_REGIONS].failures++;
+
+            portEXIT_CRITICAL(&usage_lock);
+
+            Serial.printf("error: failed to allocate %uB of %s memory for %s\n", size, region_names[region], subsystem_names[subsystem]);
+
+            return nullptr;
+        }
+
+        uint8_t* ptr = base + offset;
+
+        mem_header* header = (mem_header*) ptr - 1;
+
+        header->magic = MEM_MAGIC;
+        header->size = size;
+        header->offset = offset;
+        header->subsystem = subsystem;
+        header->region = region;
+        header->reserved = 0;
+
+        account(subsystem, region, size, true);
+
+        // 기다리던 DMA 할당이 이루어졌으므로 이후로는 여유 공간만 확인함
+        // the awaited DMA allocation has been made, so only the headroom is checked from now on
+        if(region == MEM_DMA) {
+            portENTER_CRITICAL(&usage_lock);
+
+            if(size >= report_dma_needed)
+                report_dma_needed = 0;
+
+            portEXIT_CRITICAL(&usage_lock);
+        }
+
+        return ptr;
+    }
+
+    static void account(mem_subsystem subsystem, mem_region region, size_t size, bool alloc)
+    {
+        mem_usage* cells[] = {
+            &usage[subsystem][region],
+            &usage[subsystem][MEM_REGIONS],
+            &usage[MEM_SUBSYSTEMS][region],
+            &usage[MEM_SUBSYSTEMS][MEM_REGIONS]
+        };
+
+        portENTER_CRITICAL(&usage_lock);
+
+        for(mem_usage* u: cells) {
+            if(alloc) {
+                u->current += size;
+                u->count++;
+                u->allocs++;
+
+                if(u->current > u->peak)
+                    u->peak = u->current;
+            } else {
+                u->current -= size;
+                u->count--;
+            }
+        }
+
+        portEXIT_CRITICAL(&usage_lock);
+    }
+}
@@ -0,0 +1,208 @@
+#ifndef COFFEE_MEM_HPP
+#define COFFEE_MEM_HPP
+
+#include <new>
+#include <utility>
+
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <Arduino.h>
+
+/**
+ * @def COFFEE_MEM_DMA_HEADROOM
+ * 
+ * @brief 앞으로 할당할 DMA 메모리 외에 다른 DMA 사용자를 위해 남아야 할 DMA 메모리입니다, 부족하면 주기적 메모리 보고가 경고합니다
+ * 
+ *        DMA memory that must remain for other DMA users besides the DMA memory still to be allocated, the periodic memory report warns if it does not
+ */
+#define COFFEE_MEM_DMA_HEADROOM (16 * 1024)
+
+/**
+ * @def COFFEE_MEM_REPORT_STACK
+ * 
+ * @brief 주기적 메모리 보고 태스크의 스택 크기입니다
+ * 
+ *        stack size of the periodic memory report task
+ */
+#define COFFEE_MEM_REPORT_STACK 3072
+
+namespace coffee
+{
+    enum mem_subsystem {
+        MEM_DISPLAY,
+        MEM_SD,
+        MEM_ASSETS,
+        MEM_LVGL,
+        MEM_VIDEO,
+
+        // 드라이버를 사용하는 응용 프로그램
+        // application using the driver
+        MEM_APP,
+
+        // 질의 시 모든 서브시스템의 합
+        // sum of every subsystem when querying
+        MEM_SUBSYSTEMS
+    };
+
+    enum mem_region {
+        // DMA 가능한 내부 메모리
+        // DMA-capable internal memory
+        MEM_DMA,
+
+        MEM_INTERNAL,
+
+        MEM_PSRAM,
+
+        // 질의 시 모든 영역의 합
+        // sum of every region when querying
+        MEM_REGIONS
+    };
+
+    /**
+     * @brief 추적된 할당의 사용량
+     * 
+     *        usage of tracked allocations
+     */
+    struct mem_usage {
+        // 현재 할당된 크기의 합
+        // sum of the currently allocated sizes
+        size_t current;
+
+        size_t peak;
+
+        // 현재 할당된 블록 수
+        // number of currently allocated blocks
+        uint32_t count;
+
+        uint32_t allocs;
+
+        uint32_t failures;
+    };
+
+    /**
+     * @brief 서브시스템을 표시하여 메모리를 할당하고 추적합니다, mem_free()로 해제해야 합니다
+     * 
+     *        allocates memory tagged with a subsystem and tracks it, must be freed with mem_free()
+     * 
+     * @param size 할당할 크기
+     * 
+     *             size to allocate
+     * 
+     * @param caps heap_caps_malloc()의 MALLOC_CAP_* 조합
+     * 
+     *             combination of MALLOC_CAP_* as for heap_caps_malloc()
+     * 
+     * @param subsystem 할당을 소유하는 서브시스템
+     * 
+     *                  subsystem owning the allocation
+     * 
+     * @return 할당된 메모리, 실패하면 nullptr
+     * 
+     *         allocated memory, nullptr on failure
+     */
+    void* mem_alloc(size_t size, uint32_t caps, mem_subsystem subsystem);
+
+    void* mem_calloc(size_t n, size_t size, uint32_t caps, mem_subsystem subsystem);
+
+    /**
+     * @brief mem_alloc()과 같으나 주어진 단위(2의 거듭제곱)로 정렬된 메모리를 할당합니다
+     * 
+     *        same as mem_alloc() but allocates memory aligned to the given boundary(a power of two)
+     */
+    void* mem_aligned_alloc(size_t alignment, size_t size, uint32_t caps, mem_subsystem subsystem);
+
+    void mem_free(void* ptr);
+
+    /**
+     * @brief 추적되는 메모리에 객체를 만듭니다, mem_delete()로 해제해야 합니다
+     * 
+     *        constructs an object in tracked memory, must be released with mem_delete()
+     */
+    template <typename T, typename... Args>
+    T* mem_new(mem_subsystem subsystem, Args&&... args)
+    {
+        void* ptr = mem_alloc(sizeof(T), MALLOC_CAP_8BIT, subsystem);
+        if(!ptr)
+            return nullptr;
+
+        return new(ptr) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void mem_delete(T* obj)
+    {
+        if(!obj)
+            return;
+
+        obj->~T();
+
+        mem_free(obj);
+    }
+
+    /**
+     * @brief 추적된 할당의 사용량을 가져옵니다
+     * 
+     *        gets the usage of tracked allocations
+     * 
+     * @param subsystem 서브시스템, MEM_SUBSYSTEMS이면 모든 서브시스템
+     * 
+     *                  subsystem, every subsystem if MEM_SUBSYSTEMS
+     * 
+     * @param region 메모리 영역, MEM_REGIONS이면 모든 영역
+     * 
+     *               memory region, every region if MEM_REGIONS
+     * 
+     * @param usage 사용량이 저장될 구조체
+     * 
+     *              structure to store the usage
+     */
+    void get_mem_usage(mem_subsystem subsystem, mem_region region, mem_usage* usage);
+
+    /**
+     * @brief 서브시스템 및 영역별 사용량과 각 힙의 여유 공간을 출력합니다
+     * 
+     *        prints the usage of each subsystem and region and the free space of each heap
+     */
+    void print_mem_usage(void);
+
+    /**
+     * @brief 주기적으로 print_mem_usage()와 check_dma_headroom()을 호출하는 태스크를 시작합니다
+     * 
+     *        starts a task calling print_mem_usage() and check_dma_headroom() periodically
+     * 
+     * @param period_ms 보고 주기
+     * 
+     *                  report period
+     * 
+     * @param dma_needed 앞으로 한 덩어리로 할당할 DMA 메모리(예: init_drivers() 전이라면 coffee::disp_buf_size), 그 크기 이상의 DMA 할당이 추적되면 0으로 바뀜
+     * 
+     *                   DMA memory still to be allocated in one piece(e.g. coffee::disp_buf_size before init_drivers()), it turns to 0 once a tracked DMA allocation of at least that size is made
+     * 
+     * @return 태스크 시작 성공 여부
+     * 
+     *         task start success
+     */
+    bool start_mem_report(uint32_t period_ms, size_t dma_needed = 0);
+
+    void stop_mem_report(void);
+
+    /**
+     * @brief 최대 연속 DMA 블록에 주어진 크기와 COFFEE_MEM_DMA_HEADROOM이 함께 들어가는지 확인하고, 들어가지 않으면 경고합니다
+     * 
+     *        checks that the given size plus COFFEE_MEM_DMA_HEADROOM fits in the largest free DMA block, and warns if it does not
+     * 
+     * @param needed 앞으로 한 덩어리로 할당할 DMA 메모리
+     * 
+     *               DMA memory still to be allocated in one piece
+     * 
+     * @return 여유가 있는지 여부
+     * 
+     *         whether there is headroom
+     */
+    bool check_dma_headroom(size_t needed);
+}
+#endif
@@ -80,11 +80,178 @@ namespace coffee
      */
     static lv_fs_res_t close_dir(lv_fs_drv_t* drv, void* rddir_p);
 
+    /**
+     * @brief 주어진 클록부터 낮은 순서대로 읽기 / 검증 시험을 통과하는 가장 빠른 클록을 찾아 SD 카드를 마운트합니다
+     * 
+     *        mounts the SD card at the fastest clock passing the read / verify probe, trying from the given clock downwards
+     * 
+     * @param first 처음 시도할 COFFEE_SPI_CLKS의 번호
+     * 
+     *              index of COFFEE_SPI_CLKS to try first
+     * 
+     * @return 협상 성공 여부
+     * 
+     *         negotiation success
+     */
+    static bool negotiate(size_t first);
+
+    /**
+     * @brief 현재 클록으로 시험 섹터들을 두 번 읽어 기준 데이터와 비교합니다
+     * 
+     *        reads the probe sectors twice at the current clock and compares them with the reference data
+     * 
+     * @return 시험 통과 여부
+     * 
+     *         probe success
+     */
+    static bool probe(const uint8_t* reference, uint8_t* buf);
+
+    static bool read_sectors(uint8_t* buf);
+
+    static bool mount(uint32_t clock);
+
+    /**
+     * @brief 현재 클록보다 한 단계 낮은 클록부터 다시 협상합니다, SD 카드를 독점한 채 호출해야 합니다
+     * 
+     *        renegotiates the clock starting from one step below the current one, must be called while holding the SD card exclusively
+     */
+    static bool remount(void);
+
+    /**
+     * @brief 클록 재협상이 필요하다고 알려지면 다른 태스크의 작업이 끝난 뒤 재마운트합니다
+     * 
+     *        remounts the card after the operations of other tasks finish when a clock renegotiation is signaled
+     */
+    static void renegotiate_task(void* arg);
+
+    /**
+     * @brief 기준 섹터들과 카드 크기로 카드를 구분하는 값을 만듭니다, Arduino SD 라이브러리는 CID를 읽을 수 없음
+     * 
+     *        makes a value telling cards apart from the reference sectors and the card size, the Arduino SD library cannot read the CID
+     */
+    static uint32_t fingerprint(const uint8_t* reference, size_t len);
+
+    /**
+     * @brief 추적 중인 파일들의 위치를 기억하고 닫습니다
+     * 
+     *        remembers the position of the tracked files and closes them
+     */
+    static void close_tracked(void);
+
+    /**
+     * @brief 추적 중인 파일들을 기억한 위치로 다시 엽니다, 다른 카드라면 다시 열지 않습니다
+     * 
+     *        reopens the tracked files at their remembered position, they are not reopened on a different card
+     */
+    static void reopen_tracked(bool same_card);
+
+    /**
+     * @brief 읽기 시도 하나의 결과를 통계와 오류율 창에 기록합니다
+     * 
+     *        records the result of a single read attempt to the statistics and the error rate window
+     */
+    /**
+     * @brief 읽기 시도를 기록하고, 오류율이 COFFEE_SD_ERROR_PCT에 이르면 재협상 태스크를 깨웁니다
+     * 
+     *        records a read attempt and wakes the renegotiation task once the error rate reaches COFFEE_SD_ERROR_PCT
+     */
+    static void record_attempt(bool ok);
+
+    static const uint32_t clocks[] = COFFEE_SPI_CLKS;
+
+    static constexpr size_t clock_count = sizeof(clocks) / sizeof(clocks[0]);
+
+    // 현재 클록의 COFFEE_SPI_CLKS 번호
+    // index of the current clock in COFFEE_SPI_CLKS
+    static size_t current_clock = 0;
+
+    static sd_stats stats;
+
+    // 오류율 창
+    // error rate window
+    static uint32_t window_reads = 0;
+
+    static uint32_t window_errors = 0;
+
+    /**
+     * @brief 재마운트 후 다시 열 파일
+     * 
+     *        file reopened after a remount
+     */
+    struct tracked_file {
+        File* file;
+
+        char* path;
+
+        // 다시 열 때의 모드, 다시 열지 않는다면 nullptr
+        // mode used when reopening, nullptr if it is not reopened
+        const char* mode;
+
+        uint32_t pos;
+    };
+
+    static tracked_file tracked[COFFEE_SD_MAX_FILES] = {};
+
+    // SD 카드 작업을 직렬화하는 뮤텍스, 아래 상태들과 current_clock, 추적 중인 파일들은 이 뮤텍스를 가진 채로만 접근함
+    // mutex serializing SD card operations, the states below, current_clock and the tracked files are only accessed while holding it
+    static SemaphoreHandle_t sd_mutex = nullptr;
+
+    // 뮤텍스를 가진 태스크의 점유 깊이
+    // hold depth of the task owning the mutex
+    static uint32_t depth = 0;
+
+    static bool renegotiate_pending = false;
+
+    static TaskHandle_t sd_task = nullptr;
+
+    static bool mounted = false;
+
+    static uint32_t card_id = 0;
+
+    // 통계와 함께 stats_lock으로 보호됨
+    // protected by stats_lock along with the statistics
+    static uint32_t mounts = 0;
+
+    static uint32_t cards = 0;
+
+    static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
     bool init_sd(char fs_letter)
     {
-        SPI.begin(COFFEE_SD_SCK, COFFEE_SD_MISO, COFFEE_SD_MOSI, COFFEE_SD_CS);
+        if(!sd_mutex)
+            sd_mutex = xSemaphoreCreateRecursiveMutex();
+
+        if(!sd_mutex) {
+            Serial.println("error: failed to create SD card mutex");
+
+            return false;
+        }
+
+        // SD 카드를 점유한 태스크(예: 이미지를 디코딩하는 lvgl 태스크)가 재마운트를 떠안지 않도록 전용 태스크에서 재협상함
+        // renegotiates in a dedicated task so the task holding the SD card(e.g. lvgl decoding an image) is not left with the remount
+        if(!sd_task && xTaskCreate(renegotiate_task, "sd_renegotiate", COFFEE_SD_TASK_STACK, nullptr, 2, &sd_task) != pdPASS) {
+            sd_task = nullptr;
+
+            Serial.println("error: failed to create SD card renegotiation task");
+
+            return false;
+        }
+
+        SPI.begin(board::sd_sck, board::sd_miso, board::sd_mosi, board::sd_cs);
+
+        // COFFEE_SPI_CLK보다 빠른 클록은 건너뜀
+        // skips clocks faster than COFFEE_SPI_CLK
+        size_t first = 0;
+        while(first < clock_count - 1 && clocks[first] > COFFEE_SPI_CLK)
+            first++;
+
+        xSemaphoreTakeRecursive(sd_mutex, portMAX_DELAY);
+
+        bool ok = negotiate(first);
+
+        xSemaphoreGiveRecursive(sd_mutex);
 
-        if(!SD.begin(COFFEE_SD_CS, SPI, COFFEE_SPI_CLK)) {
+        if(!ok) {
             Serial.println("error: failed to initialize SD card driver");
 
             return false;
@@ -104,8 +271,18 @@ namespace coffee
     {
         Serial.printf("files in SD card: %c:", COFFEE_FS_LETTER);
 
+        if(!hold_sd()) {
+            Serial.println("error: SD card is not mounted");
+
+            return;
+        }
+
         File root = SD.open("/");
         list_dir(root, "");
+
+        root.close();
+
+        release_sd();
     }
 
     void list_dir(File& root, const char* dir_name, uint8_t depth)
@@ -132,6 +309,453 @@ namespace coffee
         }
     }
 
+    size_t read_sd(File& file, uint8_t* buf, size_t len)
+    {
+        if(!hold_sd())
+            return 0;
+
+        size_t pos = file.position();
+        size_t size = file.size();
+
+        // 파일 끝에서 짧게 읽히는 것은 오류가 아님
+        // a short read at the end of the file is not an error
+        size_t want = (pos < size) ? min(len, size - pos) : 0;
+        size_t got = 0;
+
+        int64_t start = esp_timer_get_time();
+
+        for(uint8_t attempt = 0; got < want; attempt++) {
+            got += file.read(buf + got, want - got);
+
+            bool ok = got == want;
+
+            record_attempt(ok);
+
+            if(ok)
+                break;
+
+            portENTER_CRITICAL(&stats_lock);
+
+            if(attempt == COFFEE_SD_RETRIES)
+                stats.failures++;
+            else
+                stats.retries++;
+
+            portEXIT_CRITICAL(&stats_lock);
+
+            if(attempt == COFFEE_SD_RETRIES)
+                break;
+
+            file.seek(pos + got);
+        }
+
+        uint32_t elapsed = esp_timer_get_time() - start;
+
+        portENTER_CRITICAL(&stats_lock);
+
+        stats.reads++;
+        stats.bytes_read += got;
+        stats.read_us += elapsed;
+
+        portEXIT_CRITICAL(&stats_lock);
+
+        release_sd();
+
+        return got;
+    }
+
+    bool hold_sd(void)
+    {
+        if(!sd_mutex)
+            return false;
+
+        xSemaphoreTakeRecursive(sd_mutex, portMAX_DELAY);
+
+        // 바깥쪽 점유라면 뮤텍스를 잠시 놓아 재협상 태스크가 재마운트하도록 함, 시간 안에 끝나지 않으면 점유하지 않음
+        // at the outermost hold the mutex is let go for a while so the renegotiation task can remount, the card is not held if it does not finish in time
+        if(!depth && renegotiate_pending) {
+            TickType_t start = xTaskGetTickCount();
+            TickType_t wait = pdMS_TO_TICKS(COFFEE_SD_RENEGOTIATE_WAIT);
+
+            while(renegotiate_pending) {
+                TickType_t elapsed = xTaskGetTickCount() - start;
+
+                // 재협상 태스크가 아직 뮤텍스를 가져가지 못했다면 현재 클록으로 계속함
+                // continues at the current clock if the renegotiation task has not taken the mutex yet
+                if(elapsed >= wait)
+                    break;
+
+                xSemaphoreGiveRecursive(sd_mutex);
+
+                vTaskDelay(1);
+
+                elapsed = xTaskGetTickCount() - start;
+
+                if(xSemaphoreTakeRecursive(sd_mutex, elapsed < wait ? wait - elapsed : 0) != pdTRUE)
+                    return false;
+            }
+        }
+
+        if(!mounted) {
+            xSemaphoreGiveRecursive(sd_mutex);
+
+            return false;
+        }
+
+        depth++;
+
+        return true;
+    }
+
+    void release_sd(void)
+    {
+        depth--;
+
+        xSemaphoreGiveRecursive(sd_mutex);
+    }
+
+    bool track_sd(File* file, const char* path, const char* mode)
+    {
+        if(!sd_mutex)
+            return false;
+
+        char* copy = (char*) mem_alloc(strlen(path) + 1, MALLOC_CAP_8BIT, MEM_SD);
+        if(!copy)
+            return false;
+
+        strcpy(copy, path);
+
+        xSemaphoreTakeRecursive(sd_mutex, portMAX_DELAY);
+
+        tracked_file* slot = nullptr;
+
+        for(tracked_file& t: tracked)
+            if(!t.file) {
+                slot = &t;
+
+                break;
+            }
+
+        if(slot)
+            *slot = { file, copy, mode, 0 };
+
+        xSemaphoreGiveRecursive(sd_mutex);
+
+        if(!slot) {
+            Serial.println("error: too many SD card files are open, increase COFFEE_SD_MAX_FILES");
+
+            mem_free(copy);
+        }
+
+        return slot;
+    }
+
+    void untrack_sd(File* file)
+    {
+        if(!sd_mutex)
+            return;
+
+        xSemaphoreTakeRecursive(sd_mutex, portMAX_DELAY);
+
+        for(tracked_file& t: tracked)
+            if(t.file == file) {
+                mem_free(t.path);
+
+                t = {};
+            }
+
+        xSemaphoreGiveRecursive(sd_mutex);
+    }
+
+    bool renegotiate_sd(void)
+    {
+        if(!sd_mutex)
+            return false;
+
+        xSemaphoreTakeRecursive(sd_mutex, portMAX_DELAY);
+
+        // 이 태스크가 점유 중이라면 그 작업 도중에 재마운트하게 됨
+        // remounting while this task holds the card would pull it from under that operation
+        bool ok = !depth && remount();
+
+        xSemaphoreGiveRecursive(sd_mutex);
+
+        return ok;
+    }
+
+    uint32_t get_sd_mounts(uint32_t* cards_)
+    {
+        portENTER_CRITICAL(&stats_lock);
+
+        uint32_t count = mounts;
+
+        if(cards_)
+            *cards_ = cards;
+
+        portEXIT_CRITICAL(&stats_lock);
+
+        return count;
+    }
+
+    void get_sd_stats(sd_stats* stats_)
+    {
+        portENTER_CRITICAL(&stats_lock);
+        *stats_ = stats;
+        portEXIT_CRITICAL(&stats_lock);
+    }
+
+    void print_sd_stats(void)
+    {
+        sd_stats s;
+        get_sd_stats(&s);
+
+        uint32_t kbps = s.read_us ? s.bytes_read * 1000000 / 1024 / s.read_us : 0;
+
+        Serial.printf("SD card: %uHz, probe %uKB/s, achieved %uKB/s(%lluB read)\n", s.clock, s.probe_kbps, kbps, s.bytes_read);
+        Serial.printf("    reads %u, errors %u, retries %u, failures %u, write errors %u, renegotiations %u\n",
+                      s.reads, s.errors, s.retries, s.failures, s.write_errors, s.renegotiations);
+    }
+
+    static bool negotiate(size_t first)
+    {
+        const size_t probe_size = COFFEE_SD_PROBE_SECTORS * 512;
+
+        // 재마운트하면 열린 파일들이 무효가 되므로 먼저 닫음
+        // remounting invalidates the open files, so they are closed first
+        close_tracked();
+
+        uint8_t* reference = (uint8_t*) mem_alloc(probe_size, MALLOC_CAP_SPIRAM, MEM_SD);
+        uint8_t* buf = (uint8_t*) mem_alloc(probe_size, MALLOC_CAP_SPIRAM, MEM_SD);
+
+        bool ok = false;
+
+        size_t clock = 0;
+        uint32_t elapsed = 0;
+        uint32_t id = 0;
+
+        // 가장 느린 클록으로 읽은 데이터를 기준으로 삼음
+        // data read at the slowest clock is the reference
+        if(reference && buf && mount(clocks[clock_count - 1]) && read_sectors(reference)) {
+            id = fingerprint(reference, probe_size);
+
+            for(size_t i = first; i < clock_count; i++) {
+                if(!mount(clocks[i]))
+                    continue;
+
+                int64_t start = esp_timer_get_time();
+
+                if(!probe(reference, buf)) {
+                    Serial.printf("warning: SD card is unstable at %uHz\n", clocks[i]);
+
+                    continue;
+                }
+
+                elapsed = esp_timer_get_time() - start;
+
+                clock = i;
+                ok = true;
+
+                break;
+            }
+        }
+
+        mem_free(reference);
+        mem_free(buf);
+
+        // 실패한 시험 클록으로 마운트된 채 남지 않도록 함
+        // does not leave the card mounted at a clock that failed the probe
+        if(!ok)
+            SD.end();
+
+        bool same_card = ok && mounts && id == card_id;
+
+        portENTER_CRITICAL(&stats_lock);
+
+        if(ok) {
+            // 다른 카드는 이전 카드의 통계를 이어받지 않으며, 같은 카드라도 오류 통계는 새 클록에서 다시 셈
+            // a different card does not inherit the statistics of the previous one, and even on the same card the errors are counted anew at the new clock
+            if(!same_card) {
+                stats = {};
+
+                cards++;
+            } else {
+                stats.errors = 0;
+                stats.retries = 0;
+                stats.failures = 0;
+                stats.write_errors = 0;
+            }
+
+            stats.clock = clocks[clock];
+            stats.probe_kbps = elapsed ? (uint64_t) probe_size * 2 * 1000000 / 1024 / elapsed : 0;
+
+            mounts++;
+        } else
+            stats.clock = 0;
+
+        window_reads = 0;
+        window_errors = 0;
+
+        portEXIT_CRITICAL(&stats_lock);
+
+        mounted = ok;
+
+        if(ok) {
+            if(cards > 1 && !same_card)
+                Serial.println("warning: a different SD card is mounted, files open on the previous card stay closed");
+
+            current_clock = clock;
+            card_id = id;
+
+            reopen_tracked(same_card);
+        }
+
+        return ok;
+    }
+
+    static bool probe(const uint8_t* reference, uint8_t* buf)
+    {
+        const size_t probe_size = COFFEE_SD_PROBE_SECTORS * 512;
+
+        for(int i = 0; i < 2; i++) {
+            memset(buf, 0, probe_size);
+
+            if(!read_sectors(buf) || memcmp(reference, buf, probe_size))
+                return false;
+        }
+
+        return true;
+    }
+
+    static bool read_sectors(uint8_t* buf)
+    {
+        for(uint32_t sector = 0; sector < COFFEE_SD_PROBE_SECTORS; sector++)
+            if(!SD.readRAW(buf + sector * 512, sector))
+                return false;
+
+        return true;
+    }
+
+    static bool mount(uint32_t clock)
+    {
+        SD.end();
+
+        return SD.begin(board::sd_cs, SPI, clock);
+    }
+
+    static bool remount(void)
+    {
+        renegotiate_pending = false;
+
+        size_t first = min(current_clock + 1, clock_count - 1);
+
+        Serial.printf("warning: renegotiating SD card clock from %uHz\n", clocks[first]);
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.renegotiations++;
+        portEXIT_CRITICAL(&stats_lock);
+
+        if(!negotiate(first)) {
+            Serial.println("error: failed to remount SD card, it stays unmounted until renegotiate_sd() succeeds");
+
+            return false;
+        }
+
+        return true;
+    }
+
+    static void renegotiate_task(void* arg)
+    {
+        for(;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            xSemaphoreTakeRecursive(sd_mutex, portMAX_DELAY);
+
+            // 그 사이 renegotiate_sd()가 먼저 재협상했을 수 있음
+            // renegotiate_sd() may have renegotiated first in the meantime
+            if(renegotiate_pending)
+                remount();
+
+            xSemaphoreGiveRecursive(sd_mutex);
+        }
+    }
+
+    static uint32_t fingerprint(const uint8_t* reference, size_t len)
+    {
+        uint64_t size = SD.cardSize();
+
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+
+        for(int i = 0; i < 8; i++)
+            hash = (hash ^ (uint8_t) (size >> (i * 8))) * 16777619u;
+
+        for(size_t i = 0; i < len; i++)
+            hash = (hash ^ reference[i]) * 16777619u;
+
+        return hash;
+    }
+
+    static void close_tracked(void)
+    {
+        for(tracked_file& t: tracked)
+            if(t.file && *t.file) {
+                t.pos = t.file->position();
+
+                t.file->close();
+            }
+    }
+
+    static void reopen_tracked(bool same_card)
+    {
+        for(tracked_file& t: tracked) {
+            if(!t.file || !t.mode)
+                continue;
+
+            if(same_card) {
+                *t.file = SD.open(t.path, t.mode);
+
+                if(*t.file && t.file->seek(t.pos))
+                    continue;
+
+                Serial.printf("error: failed to reopen %s after remounting SD card\n", t.path);
+
+                t.file->close();
+            }
+
+            // 닫힌 채로 남은 파일은 이후 재마운트에서도 다시 열지 않음
+            // a file left closed is not reopened at later remounts either
+            t.mode = nullptr;
+        }
+    }
+
+    static void record_attempt(bool ok)
+    {
+        bool wake = false;
+
+        portENTER_CRITICAL(&stats_lock);
+
+        if(!ok) {
+            stats.errors++;
+            window_errors++;
+        }
+
+        if(++window_reads >= COFFEE_SD_ERROR_WINDOW) {
+            if(window_errors * 100 >= window_reads * COFFEE_SD_ERROR_PCT && current_clock < clock_count - 1) {
+                wake = !renegotiate_pending;
+
+                renegotiate_pending = true;
+            }
+
+            window_reads = 0;
+            window_errors = 0;
+        }
+
+        portEXIT_CRITICAL(&stats_lock);
+
+        if(wake)
+            xTaskNotifyGive(sd_task);
+    }
+
     static bool init_lv_fs(char fs_letter)
     {
         // lvgl 파일 시스템 드라이버
@@ -176,13 +800,20 @@ namespace coffee
         if(!mode_str)
             return nullptr;
 
-        File* file = new File(SD.open(path, mode_str));
-        if(!*file || !file->available()) {
-            delete file;
-
+        if(!hold_sd())
             return nullptr;
+
+        // 쓰기 모드로 다시 열면 파일이 비워지므로, 재마운트 후에는 읽기 / 쓰기 모드로 다시 엶
+        // reopening in write mode would empty the file, so it is reopened in read / write mode after a remount
+        File* file = mem_new<File>(MEM_SD, SD.open(path, mode_str));
+        if(!file || !*file || !file->available() || !track_sd(file, path, (mode == LV_FS_MODE_WR) ? "r+" : FILE_READ)) {
+            mem_delete(file);
+
+            file = nullptr;
         }
 
+        release_sd();
+
         return file;
     }
 
@@ -191,9 +822,18 @@ namespace coffee
         File* file = static_cast<File*>(file_p);
 
         if(file) {
+            // 마운트되지 않았다면 파일은 이미 닫혀 있음
+            // the file is already closed if the card is not mounted
+            bool held = hold_sd();
+
+            untrack_sd(file);
+
             file->close();
 
-            delete file;
+            mem_delete(file);
+
+            if(held)
+                release_sd();
         }
 
         return LV_FS_RES_OK;
@@ -205,7 +845,12 @@ namespace coffee
         if(!file)
             return LV_FS_RES_INV_PARAM;
 
-        *br = file->read(static_cast<uint8_t*>(buf), btr);
+        if(!hold_sd())
+            return LV_FS_RES_HW_ERR;
+
+        *br = read_sd(*file, static_cast<uint8_t*>(buf), btr);
+
+        release_sd();
 
         return LV_FS_RES_OK;
     }
@@ -216,8 +861,19 @@ namespace coffee
         if(!file)
             return LV_FS_RES_INV_PARAM;
 
+        if(!hold_sd())
+            return LV_FS_RES_HW_ERR;
+
         *bw = file->write(static_cast<const uint8_t*>(buf), btw);
 
+        release_sd();
+
+        if(*bw != btw) {
+            portENTER_CRITICAL(&stats_lock);
+            stats.write_errors++;
+            portEXIT_CRITICAL(&stats_lock);
+        }
+
         return (*bw == btw) ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
     }
 
@@ -227,14 +883,20 @@ namespace coffee
         if(!file)
             return LV_FS_RES_INV_PARAM;
 
+        if(whence != LV_FS_SEEK_SET && whence != LV_FS_SEEK_CUR && whence != LV_FS_SEEK_END)
+            return LV_FS_RES_INV_PARAM;
+
+        if(!hold_sd())
+            return LV_FS_RES_HW_ERR;
+
         if(whence == LV_FS_SEEK_SET)
             file->seek(pos);
         else if(whence == LV_FS_SEEK_CUR)
             file->seek(file->position() + pos);
-        else if(whence == LV_FS_SEEK_END)
-            file->seek(file->size() + pos);
         else
-            return LV_FS_RES_INV_PARAM;
+            file->seek(file->size() + pos);
+
+        release_sd();
 
         return LV_FS_RES_OK;
     }
@@ -245,18 +907,39 @@ namespace coffee
         if(!file)
             return LV_FS_RES_INV_PARAM;
 
+        if(!hold_sd())
+            return LV_FS_RES_HW_ERR;
+
         *pos_p = file->position();
 
+        release_sd();
+
         return LV_FS_RES_OK;
     }
 
     static void* open_dir(lv_fs_drv_t* drv, const char* path)
     {
-        File dir = SD.open(path);
-        if(!dir || !dir.isDirectory())
+        if(!hold_sd())
             return nullptr;
 
-        return new File(dir);
+        File* file = nullptr;
+
+        // 디렉토리는 재마운트 후 다시 열지 않으며, 읽기가 끝난 것처럼 동작함
+        // directories are not reopened after a remount and behave as if fully read
+        File dir = SD.open(path);
+        if(dir && dir.isDirectory()) {
+            file = mem_new<File>(MEM_SD, dir);
+
+            if(file && !track_sd(file, path, nullptr)) {
+                mem_delete(file);
+
+                file = nullptr;
+            }
+        }
+
+        release_sd();
+
+        return file;
     }
 
     static lv_fs_res_t read_dir(lv_fs_drv_t* drv, void* rddir_p, char* fn)
@@ -265,10 +948,15 @@ namespace coffee
         if(!file)
             return LV_FS_RES_INV_PARAM;
 
+        if(!hold_sd())
+            return LV_FS_RES_HW_ERR;
+
         File entry = file->openNextFile();
         if(!entry) {
             fn[0] = '\0';
 
+            release_sd();
+
             return LV_FS_RES_OK;
         }
 
@@ -277,6 +965,8 @@ namespace coffee
 
         entry.close();
 
+        release_sd();
+
         return LV_FS_RES_OK;
     }
 
@@ -285,9 +975,16 @@ namespace coffee
         File* dir = static_cast<File*>(rddir_p);
 
         if(dir) {
+            bool held = hold_sd();
+
+            untrack_sd(dir);
+
             dir->close();
 
-            delete dir;
+            mem_delete(dir);
+
+            if(held)
+                release_sd();
         }
         
         return LV_FS_RES_OK;
@@ -3,6 +3,12 @@
 
 #include <string.h>
 
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
 #include <Arduino.h>
 
 #include <FS.h>
@@ -12,25 +18,93 @@
 #include <lvgl.h>
 
 #include "def.h"
-
-#define COFFEE_SD_CS 10
-#define COFFEE_SD_MOSI 11
-#define COFFEE_SD_SCK 12
-#define COFFEE_SD_MISO 13
+#include "mem.hpp"
 
 /**
  * @def COFFEE_SPI_CLK
  * 
- * @brief ESP32는 SPI 클록을 최대 80MHz까지 지원하지만, 불안정할 수 있습니다
+ * @brief 시도할 최대 SPI 클록입니다, ESP32는 SPI 클록을 최대 80MHz까지 지원합니다
  * 
- *        만약 SD 카드 읽기 / 쓰기가 불안정하다면, 이 값을 40000000으로 바꾸세요
+ *        실제 클록은 init_sd()에서 읽기 / 검증 시험을 통과하는 가장 빠른 COFFEE_SPI_CLKS 값으로 정해집니다
  * 
- *        ESP32 supports SPI clock up to 80MHz, but it can be unstable
+ *        maximum SPI clock to try, ESP32 supports SPI clock up to 80MHz
  * 
- *        if SD card read / write is unstable, change this value to 40000000
+ *        the actual clock is the fastest of COFFEE_SPI_CLKS passing the read / verify probe in init_sd()
  */
 #define COFFEE_SPI_CLK 80000000
 
+/**
+ * @def COFFEE_SPI_CLKS
+ * 
+ * @brief SPI 클록 협상 시 빠른 순서대로 시도할 클록들입니다, 마지막 값은 검증의 기준으로도 사용됩니다
+ * 
+ *        clocks tried in order of speed when negotiating the SPI clock, the last one is also the reference for verification
+ */
+#define COFFEE_SPI_CLKS { 80000000, 40000000, 26666667, 20000000, 16000000, 10000000, 4000000 }
+
+/**
+ * @def COFFEE_SD_PROBE_SECTORS
+ * 
+ * @brief 클록 협상 시 읽고 검증할 섹터(512B) 수입니다
+ * 
+ *        number of sectors(512B) read and verified when negotiating the clock
+ */
+#define COFFEE_SD_PROBE_SECTORS 16
+
+/**
+ * @def COFFEE_SD_RETRIES
+ * 
+ * @brief 읽기에 실패했을 때 다시 시도할 횟수입니다
+ * 
+ *        number of retries when a read fails
+ */
+#define COFFEE_SD_RETRIES 2
+
+/**
+ * @def COFFEE_SD_ERROR_WINDOW
+ * 
+ * @brief 오류율을 계산하는 읽기 횟수 단위입니다
+ * 
+ *        number of reads the error rate is computed over
+ */
+#define COFFEE_SD_ERROR_WINDOW 256
+
+/**
+ * @def COFFEE_SD_ERROR_PCT
+ * 
+ * @brief 오류율이 이 값(%) 이상이면 전용 태스크가 한 단계 낮은 클록부터 다시 협상합니다
+ * 
+ *        if the error rate reaches this value(%), the clock is renegotiated from one step lower by a dedicated task
+ */
+#define COFFEE_SD_ERROR_PCT 2
+
+/**
+ * @def COFFEE_SD_RENEGOTIATE_WAIT
+ * 
+ * @brief 재협상 태스크가 진행 중일 때 SD 카드를 점유하려는 태스크가 기다리는 최대 시간(ms)입니다
+ * 
+ *        maximum time(ms) a task holding the SD card waits while the renegotiation task is running
+ */
+#define COFFEE_SD_RENEGOTIATE_WAIT 20
+
+/**
+ * @def COFFEE_SD_TASK_STACK
+ * 
+ * @brief 클록 재협상 태스크의 스택 크기입니다
+ * 
+ *        stack size of the clock renegotiation task
+ */
+#define COFFEE_SD_TASK_STACK 4096
+
+/**
+ * @def COFFEE_SD_MAX_FILES
+ * 
+ * @brief 재마운트 후 다시 열도록 추적할 수 있는 파일 및 디렉토리 수입니다
+ * 
+ *        number of files and directories that can be tracked to be reopened after a remount
+ */
+#define COFFEE_SD_MAX_FILES 8
+
 /**
  * @def COFFEE_LIST_FILES
  * 
@@ -66,6 +140,126 @@ namespace coffee
      */
     bool init_sd(char fs_letter);
 
+    /**
+     * @brief SD 카드 읽기 통계, 오류 통계는 재마운트할 때, 모든 통계는 다른 카드가 마운트될 때 초기화됩니다
+     * 
+     *        SD card read statistics, the error statistics are reset at every remount and all of them when a different card is mounted
+     */
+    struct sd_stats {
+        // 협상된 SPI 클록, 마운트되지 않았다면 0
+        // negotiated SPI clock, 0 if not mounted
+        uint32_t clock;
+
+        // 협상 시 측정된 읽기 속도(KB/s)
+        // read speed measured while negotiating(KB/s)
+        uint32_t probe_kbps;
+
+        uint32_t reads;
+
+        // 실패한 읽기 시도 수, Arduino SD 라이브러리는 CRC 오류와 시간 초과를 구분하지 않음
+        // number of failed read attempts, the Arduino SD library does not tell CRC errors from timeouts
+        uint32_t errors;
+
+        uint32_t retries;
+
+        // 다시 시도해도 실패한 읽기 수
+        // number of reads that failed even after retrying
+        uint32_t failures;
+
+        uint32_t write_errors;
+
+        uint32_t renegotiations;
+
+        uint64_t bytes_read;
+
+        uint64_t read_us;
+    };
+
+    /**
+     * @brief SD 카드를 점유한 채 파일에서 데이터를 읽습니다, 실패하면 다시 시도하며 읽기 통계에 기록합니다
+     * 
+     *        reads data from a file while holding the SD card, retries on failure and records it to the read statistics
+     * 
+     * @return 읽은 바이트 수
+     * 
+     *         number of bytes read
+     */
+    size_t read_sd(File& file, uint8_t* buf, size_t len);
+
+    /**
+     * @brief 다른 태스크가 끝날 때까지 기다린 뒤 SD 카드를 독점합니다, 중첩해서 호출할 수 있으며 release_sd()로 풀어야 합니다
+     * 
+     *        클록 재협상이 대기 중이라면 바깥쪽 점유는 재협상 태스크가 재마운트를 마칠 때까지 최대 COFFEE_SD_RENEGOTIATE_WAIT 동안 기다리므로, SD 카드의 파일은 작업 하나 동안만 점유해야 합니다
+     * 
+     *        waits for other tasks to finish and takes the SD card exclusively, it can be nested and must be released with release_sd()
+     * 
+     *        with a clock renegotiation pending, the outermost hold waits up to COFFEE_SD_RENEGOTIATE_WAIT for the renegotiation task to remount the card, so hold the card only for a single operation on its files
+     * 
+     * @return 점유 성공 여부, 카드가 마운트되지 않았거나 재마운트가 시간 안에 끝나지 않으면 점유하지 않고 false
+     * 
+     *         hold success, false without holding if the card is not mounted or the remount does not finish in time
+     */
+    bool hold_sd(void);
+
+    void release_sd(void);
+
+    /**
+     * @brief 재마운트 후 같은 위치로 다시 열도록 파일을 추적합니다, SD.open()으로 열어 여러 작업에 걸쳐 사용하는 파일은 추적해야 합니다
+     * 
+     *        디렉토리는 다시 열지 않고 닫기만 합니다
+     * 
+     *        tracks a file to be reopened at the same position after a remount, files opened with SD.open() and used across operations must be tracked
+     * 
+     *        directories are only closed, not reopened
+     * 
+     * @param mode 다시 열 때 사용할 모드, 디렉토리라면 nullptr
+     * 
+     *             mode used when reopening, nullptr for a directory
+     * 
+     * @return 추적 성공 여부, COFFEE_SD_MAX_FILES개를 넘으면 false
+     * 
+     *         track success, false beyond COFFEE_SD_MAX_FILES
+     */
+    bool track_sd(File* file, const char* path, const char* mode);
+
+    void untrack_sd(File* file);
+
+    /**
+     * @brief 현재 클록보다 한 단계 낮은 클록부터 다시 협상합니다, 협상에 실패하면 카드는 마운트 해제됩니다
+     * 
+     *        renegotiates the clock starting from one step below the current one, the card is unmounted if it fails
+     * 
+     * @return 재협상 성공 여부, SD 카드를 점유한 채 호출했다면 false
+     * 
+     *         renegotiation success, false if called while holding the SD card
+     */
+    bool renegotiate_sd(void);
+
+    /**
+     * @brief SD 카드가 마운트된 횟수를 가져옵니다, 값이 바뀌었다면 그 전에 stdio로 연 파일은 다시 열어야 합니다
+     * 
+     *        gets how many times the SD card has been mounted, files opened with stdio before it changed must be reopened
+     * 
+     * @param cards 다른 카드가 마운트된 횟수, 값이 바뀌었다면 파일을 다시 열지 말아야 합니다
+     * 
+     *              how many times a different card has been mounted, files must not be reopened if it changed
+     */
+    uint32_t get_sd_mounts(uint32_t* cards = nullptr);
+
+    /**
+     * @brief SD 카드 읽기 통계를 가져옵니다
+     * 
+     *        gets the SD card read statistics
+     */
+    void get_sd_stats(sd_stats* stats);
+
+    /**
+     * @brief SD 카드 클록과 읽기 통계를 출력합니다
+     * 
+     *        prints the SD card clock and read statistics
+     */
+    void print_sd_stats(void);
+
     /**
      * @brief 파일 시스템 내의 모든 파일을 표시합니다
      * 
@@ -2,17 +2,6 @@
 
 namespace coffee
 {
-    /**
-     * @brief GT911을 통해 터치를 감지하면 마지막으로 터치된 위치를 last_x와 last_y에 저장합니다
-     * 
-     *        if touch is detected via the GT911, stores the last touched position into last_x and last_y
-     * 
-     * @return 터치 감지 여부
-     * 
-     *         whether touch was detected
-     */
-    static bool is_touched(void);
-
     /**
      * @brief lv_hal_indev에서 입력 기기를 읽을 때 콜백됩니다
      * 
@@ -24,26 +13,30 @@ namespace coffee
 
     int last_y = 0;
     
+    static_assert(TOUCH_ROTATION_NORMAL == ROTATION_NORMAL, "touch_orientation must follow the ROTATION_* values of TAMC_GT911");
+
     // 터치 제어를 위한 GT911 드라이버
     // GT911 driver for touch control
-    static TAMC_GT911 touch = TAMC_GT911(COFFEE_GT911_SDA, COFFEE_GT911_SCL, COFFEE_GT911_INT, COFFEE_GT911_RST, max(COFFEE_MAP_X1, COFFEE_MAP_X2), max(COFFEE_MAP_Y1, COFFEE_MAP_Y2));
+    static basic_touch<board> touch;
 
     bool init_touch(void)
     {
         // lvgl 터치 드라이버
         // lvgl touch driver
         static lv_indev_drv_t indev_drv;
+
+        if(board::touch == TOUCH_NONE) {
+            Serial.println("warning: no touch controller is configured for this board, touch input is disabled");
+
+            return false;
+        }
         
-        if(!Wire.begin(COFFEE_GT911_SDA, COFFEE_GT911_SCL)) {
+        if(!i2c.begin() || !touch.begin()) {
             Serial.println("error: failed to initialize touch driver");
             
             return false;
         }
 
-        touch.begin();
-        
-        touch.setRotation(COFFEE_GT911_ROTATION);
-
         lv_indev_drv_init(&indev_drv);
         
         indev_drv.type = LV_INDEV_TYPE_POINTER;
@@ -54,22 +47,19 @@ namespace coffee
         return true;
     }
 
-    static bool is_touched(void)
+    static void read_touch(lv_indev_drv_t* indev_driver, lv_indev_data_t* indev_data)
     {
-        touch.read();
+#if COFFEE_LATENCY_TRACE
+        latency_read_start();
+#endif
 
-        if(touch.isTouched) {
-            last_x = map(touch.points[0].x, COFFEE_MAP_X1, COFFEE_MAP_X2, 0, COFFEE_WIDTH - 1);
-            last_y = map(touch.points[0].y, COFFEE_MAP_Y1, COFFEE_MAP_Y2, 0, COFFEE_HEIGHT - 1);
+        bool touched = touch.read(&last_x, &last_y);
 
-            return true;
-        } else
-            return false;
-    }
+#if COFFEE_LATENCY_TRACE
+        latency_sample(touched, last_x, last_y);
+#endif
 
-    static void read_touch(lv_indev_drv_t* indev_driver, lv_indev_data_t* indev_data)
-    {
-        if(is_touched()) {
+        if(touched) {
             indev_data->state = LV_INDEV_STATE_PR;
 
             indev_data->point.x = last_x;
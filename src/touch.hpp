@@ -9,17 +9,11 @@
 #include <lvgl.h>
 
 #include "def.h"
+#include "i2c.hpp"
+#include "latency.hpp"
 
-#define COFFEE_GT911
-#define COFFEE_GT911_SCL 20
-#define COFFEE_GT911_SDA 19
-#define COFFEE_GT911_INT 3
-#define COFFEE_GT911_RST 4
-#define COFFEE_GT911_ROTATION ROTATION_NORMAL
-#define COFFEE_MAP_X1 800
-#define COFFEE_MAP_X2 0
-#define COFFEE_MAP_Y1 480
-#define COFFEE_MAP_Y2 0
+#define COFFEE_GT911_ADDR GT911_ADDR1
+#define COFFEE_GT911_MAX_POINTS 5
 
 /**
  * @def COFFEE_PRINT_TOUCH
@@ -46,14 +40,155 @@ namespace coffee
      */
     extern int last_y;
 
+    /**
+     * @brief 보드 설명에 따라 구성되는 GT911 터치 패널
+     * 
+     *        GT911 touch panel configured from a board description
+     * 
+     * @tparam Board 보드 설명(board.hpp)
+     * 
+     *               board description(board.hpp)
+     */
+    template <typename Board>
+    class basic_touch
+    {
+    public:
+        static constexpr uint16_t width = Board::touch_map_x1 > Board::touch_map_x2 ? Board::touch_map_x1 : Board::touch_map_x2;
+
+        static constexpr uint16_t height = Board::touch_map_y1 > Board::touch_map_y2 ? Board::touch_map_y1 : Board::touch_map_y2;
+
+        basic_touch(void): _gt911(Board::i2c_sda, Board::i2c_scl, Board::touch_int, Board::touch_rst, width, height)
+        {
+        }
+
+        /**
+         * @brief GT911을 초기화합니다, i2c가 초기화된 뒤 호출해야 합니다
+         * 
+         *        initializes the GT911, must be called after i2c is initialized
+         * 
+         * @return 초기화 성공 여부, 보드에 터치 컨트롤러가 없으면 false
+         * 
+         *         initialization success, false if the board has no touch controller
+         */
+        bool begin(void)
+        {
+            if(Board::touch == TOUCH_NONE)
+                return false;
+
+            // GT911 라이브러리는 Wire를 직접 사용하므로 초기화가 끝날 때까지 버스를 점유
+            // the GT911 library uses Wire directly, so hold the bus until initialization is done
+            if(!i2c.lock()) {
+                Serial.println("error: failed to acquire I2C bus");
+
+                return false;
+            }
+
+            _gt911.begin(COFFEE_GT911_ADDR);
+
+            _gt911.setRotation(Board::touch_rotation);
+
+            i2c.unlock();
+
+            return true;
+        }
+
+        /**
+         * @brief 터치를 감지하면 첫 번째 터치 지점을 화면 좌표로 옮겨 저장합니다
+         * 
+         *        if touch is detected, maps the first touch point to screen coordinates and stores it
+         * 
+         * @return 터치 감지 여부
+         * 
+         *         whether touch was detected
+         */
+        bool read(int* x, int* y)
+        {
+            if(!read_points() || !_gt911.isTouched)
+                return false;
+
+            *x = map(_gt911.points[0].x, Board::touch_map_x1, Board::touch_map_x2, 0, Board::width - 1);
+            *y = map(_gt911.points[0].y, Board::touch_map_y1, Board::touch_map_y2, 0, Board::height - 1);
+
+            return true;
+        }
+
+    private:
+        TAMC_GT911 _gt911;
+
+        /**
+         * @brief GT911의 상태 레지스터와 모든 터치 지점을 한 번의 트랜잭션으로 읽어 _gt911에 저장합니다
+         * 
+         *        reads the GT911 status register and every touch point in a single transaction, and stores them into _gt911
+         * 
+         * @return 읽기 성공 여부
+         * 
+         *         read success
+         */
+        bool read_points(void)
+        {
+            static const uint8_t point_info[] = { GT911_POINT_INFO >> 8, GT911_POINT_INFO & 0xFF };
+            static const uint8_t clear_info[] = { GT911_POINT_INFO >> 8, GT911_POINT_INFO & 0xFF, 0 };
+
+            // 상태 레지스터(0x814E) 바로 뒤에 8바이트 크기의 터치 지점들이 연속해서 놓여 있음
+            // the 8-byte touch points follow right after the status register(0x814E)
+            uint8_t data[1 + COFFEE_GT911_MAX_POINTS * 8];
+
+            if(!i2c.write_read(COFFEE_GT911_ADDR, point_info, sizeof(point_info), data, sizeof(data)))
+                return false;
+
+            uint8_t buffer_ready = data[0] >> 7 & 1;
+
+            _gt911.touches = min(data[0] & 0xF, COFFEE_GT911_MAX_POINTS);
+            _gt911.isTouched = _gt911.touches > 0;
+
+            if(buffer_ready && _gt911.isTouched)
+                for(uint8_t i = 0; i < _gt911.touches; i++) {
+                    const uint8_t* point = data + 1 + i * 8;
+
+                    TP_Point& tp = _gt911.points[i];
+                    uint16_t x = point[1] | point[2] << 8;
+                    uint16_t y = point[3] | point[4] << 8;
+
+                    tp.id = point[0];
+                    tp.size = point[5] | point[6] << 8;
+
+                    // TAMC_GT911::readPoint()와 같은 방식으로 회전 적용
+                    // apply the rotation the same way TAMC_GT911::readPoint() does
+                    switch(Board::touch_rotation) {
+                    case ROTATION_NORMAL:
+                        tp.x = width - x;
+                        tp.y = height - y;
+                        break;
+
+                    case ROTATION_LEFT:
+                        tp.x = width - y;
+                        tp.y = x;
+                        break;
+
+                    case ROTATION_RIGHT:
+                        tp.x = y;
+                        tp.y = height - x;
+                        break;
+
+                    default:
+                        tp.x = x;
+                        tp.y = y;
+                        break;
+                    }
+                }
+
+            return i2c.write(COFFEE_GT911_ADDR, clear_info, sizeof(clear_info));
+        }
+    };
+
     /**
      * @brief 터치 스크린을 초기화합니다
      * 
      *        initializes the touch screen
      * 
-     * @return 터치 스크린 초기화 성공 여부
+     * @return 터치 스크린 초기화 성공 여부, 보드에 터치 컨트롤러가 없으면 false
      * 
-     *         touch screen initialization success
+     *         touch screen initialization success, false if the board has no touch controller
      */
     bool init_touch(void);
 }
@@ -0,0 +1,776 @@
+#include "video.hpp"
+
+#define VIDEO_RLE_SKIP 0
+#define VIDEO_RLE_FILL 1
+#define VIDEO_RLE_LITERAL 2
+
+#define VIDEO_END UINT32_MAX
+
+// 단계 간 대기를 나누는 간격, 재생을 멈출 때 각 태스크가 이 간격 안에 종료됨
+// interval waits between stages are split into, each task exits within it when playback stops
+#define VIDEO_POLL_MS 100
+
+namespace coffee
+{
+    /**
+     * @brief 압축된 프레임 하나를 담는 버퍼
+     * 
+     *        buffer holding a single compressed frame
+     */
+    struct video_slot {
+        uint8_t* data;
+
+        uint32_t size;
+
+        // 재생 시작부터 센 프레임 번호, 재생 끝이면 VIDEO_END
+        // frame number counted from the start of playback, VIDEO_END at the end of playback
+        uint32_t index;
+    };
+
+    /**
+     * @brief 복원이 끝나 화면 전송을 기다리는 프레임
+     * 
+     *        decoded frame waiting to be pushed
+     */
+    struct video_frame {
+        uint8_t buffer;
+
+        // 이전 프레임에서 바뀐 줄의 범위
+        // range of rows changed from the previous frame
+        int16_t y0;
+
+        int16_t y1;
+
+        uint32_t index;
+    };
+
+    /**
+     * @brief SD 카드에서 압축된 프레임을 읽어 복원 단계로 넘깁니다
+     * 
+     *        reads compressed frames from the SD card and passes them to the decode stage
+     */
+    static void read_task(void* arg);
+
+    /**
+     * @brief 압축된 프레임을 프레임 버퍼에 복원하여 전송 단계로 넘깁니다
+     * 
+     *        decodes compressed frames into frame buffers and passes them to the push stage
+     */
+    static void decode_task(void* arg);
+
+    /**
+     * @brief 표시 시점과 vsync에 맞춰 복원된 프레임을 화면에 전송합니다
+     * 
+     *        pushes decoded frames to the screen in time with their presentation time and vsync
+     */
+    static void push_task(void* arg);
+
+    /**
+     * @brief RLE 프레임을 복원합니다
+     * 
+     *        decodes a RLE frame
+     * 
+     * @param full 이전 프레임 없이 모든 픽셀을 담은 전체 프레임인지 여부
+     * 
+     *             whether it is a full frame holding every pixel without the previous frame
+     * 
+     * @return 복원 성공 여부
+     * 
+     *         decode success
+     */
+    static bool decode_rle(const uint8_t* src, uint32_t size, uint16_t* dst, const uint16_t* ref, int16_t* y0, int16_t* y1, bool* full);
+
+    /**
+     * @brief 프레임 버퍼의 일부 줄을 화면에 전송합니다, lcd를 점유한 상태로 호출해야 합니다
+     * 
+     *        pushes some rows of a frame buffer to the screen, must be called while lcd is locked
+     */
+    static void push_rows(uint8_t buffer, int16_t y0, int16_t y1);
+
+    /**
+     * @brief VIDEO_OVERLAY에서 lvgl이 영상 위에 그린 부분을 다시 영상으로 덮습니다
+     * 
+     *        with VIDEO_OVERLAY, covers the parts lvgl drew over the video with the video again
+     */
+    static void redraw_overlay(const lv_area_t* area);
+
+    /**
+     * @brief 큐에 항목을 넣습니다, 재생이 멈추면 포기합니다
+     * 
+     *        sends an item to a queue, gives up when playback stops
+     */
+    static bool send(QueueHandle_t queue, const void* item);
+
+    /**
+     * @brief 큐에서 항목을 꺼냅니다, 재생이 멈추면 포기합니다
+     * 
+     *        receives an item from a queue, gives up when playback stops
+     */
+    static bool receive(QueueHandle_t queue, void* item, uint32_t* stalls);
+
+    /**
+     * @brief 재생 통계 하나를 잠근 채 1 늘립니다
+     * 
+     *        increments a playback statistic under the lock
+     */
+    static void count(uint32_t* stat);
+
+    /**
+     * @brief 재생 통계 하나를 잠근 채 최댓값으로 갱신합니다
+     * 
+     *        updates a playback statistic to the maximum under the lock
+     */
+    static void count_max(uint32_t* stat, uint32_t value);
+
+    static void release_buffers(void);
+
+    /**
+     * @brief 영상 파일의 추적을 멈추고 닫습니다
+     * 
+     *        stops tracking the video file and closes it
+     */
+    static void close_file(void);
+
+    /**
+     * @brief 실행 중인 태스크들을 멈추고 재생 전 상태로 되돌립니다
+     * 
+     *        stops the running tasks and restores the state from before playback
+     * 
+     * @param tasks 종료를 기다릴 태스크 수
+     * 
+     *              number of tasks to wait for
+     */
+    static void shut_down(int tasks);
+
+    static File file;
+
+    static video_header header;
+
+    static int32_t video_x = 0;
+
+    static int32_t video_y = 0;
+
+    static video_mode mode = VIDEO_PAUSE_LVGL;
+
+    static bool looping = false;
+
+    static video_slot slots[COFFEE_VIDEO_SLOTS];
+
+    static uint16_t* frames[COFFEE_VIDEO_FRAME_BUFFERS];
+
+    // 빈 슬롯, 읽은 슬롯 번호
+    // free, filled slot indices
+    static QueueHandle_t free_slots = nullptr;
+
+    static QueueHandle_t filled_slots = nullptr;
+
+    // 빈 프레임 버퍼 번호, 복원된 프레임
+    // free frame buffer indices, decoded frames
+    static QueueHandle_t free_frames = nullptr;
+
+    static QueueHandle_t decoded_frames = nullptr;
+
+    // 각 태스크가 종료될 때 주는 세마포어
+    // semaphore each task gives when it exits
+    static SemaphoreHandle_t exited = nullptr;
+
+    // 현재 화면에 표시된 프레임 버퍼, 없으면 -1
+    // frame buffer currently shown on the screen, -1 if none
+    static volatile int shown = -1;
+
+    static volatile bool stopping = false;
+
+    static volatile bool playing = false;
+
+    static bool started = false;
+
+    static video_stats stats;
+
+    // 세 태스크가 모두 통계를 갱신하므로 필요한 잠금
+    // lock needed as all three tasks update the statistics
+    static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    bool play_video(const char* path, int32_t x, int32_t y, video_mode mode_, bool loop)
+    {
+        if(started) {
+            Serial.println("error: a video is already playing");
+
+            return false;
+        }
+
+        if(!hold_sd()) {
+            Serial.println("error: SD card is not mounted");
+
+            return false;
+        }
+
+        file = SD.open(path, FILE_READ);
+        if(!file) {
+            Serial.printf("error: failed to open video(%s)\n", path);
+
+            release_sd();
+
+            return false;
+        }
+
+        if(read_sd(file, (uint8_t*) &header, sizeof(header)) != sizeof(header) || memcmp(header.magic, "CFV1", 4)
+           || header.codec > VIDEO_RLE || !header.fps || !header.width || !header.height || x < 0 || y < 0
+           || x + header.width > board::width || y + header.height > board::height) {
+            Serial.printf("error: not a valid video, or does not fit the screen(%s)\n", path);
+
+            file.close();
+
+            release_sd();
+
+            return false;
+        }
+
+        // 재생 중에는 읽을 때만 SD 카드를 점유하므로, 그 사이에 재마운트되어도 이어 읽도록 추적함
+        // the SD card is only held while reading during playback, so the file is tracked to keep reading across a remount
+        bool tracked = track_sd(&file, path, FILE_READ);
+
+        if(!tracked)
+            file.close();
+
+        release_sd();
+
+        if(!tracked)
+            return false;
+
+        portENTER_CRITICAL(&stats_lock);
+        memset(&stats, 0, sizeof(stats));
+        portEXIT_CRITICAL(&stats_lock);
+
+        video_x = x;
+        video_y = y;
+        mode = mode_;
+        looping = loop;
+        shown = -1;
+        stopping = false;
+
+        free_slots = xQueueCreate(COFFEE_VIDEO_SLOTS + 1, sizeof(uint8_t));
+        filled_slots = xQueueCreate(COFFEE_VIDEO_SLOTS + 1, sizeof(uint8_t));
+        free_frames = xQueueCreate(COFFEE_VIDEO_FRAME_BUFFERS, sizeof(uint8_t));
+        decoded_frames = xQueueCreate(COFFEE_VIDEO_FRAME_BUFFERS, sizeof(video_frame));
+        exited = xSemaphoreCreateCounting(3, 0);
+
+        bool ok = free_slots && filled_slots && free_frames && decoded_frames && exited;
+
+        // 압축 프레임과 복원된 프레임 모두 PSRAM에 둠
+        // both compressed and decoded frames live in PSRAM
+        for(uint8_t i = 0; ok && i < COFFEE_VIDEO_SLOTS; i++) {
+            slots[i].data = (uint8_t*) mem_alloc(COFFEE_VIDEO_SLOT_SIZE, MALLOC_CAP_SPIRAM, MEM_VIDEO);
+            ok = slots[i].data && xQueueSend(free_slots, &i, 0) == pdTRUE;
+        }
+
+        for(uint8_t i = 0; ok && i < COFFEE_VIDEO_FRAME_BUFFERS; i++) {
+            frames[i] = (uint16_t*) mem_alloc(header.width * header.height * sizeof(uint16_t), MALLOC_CAP_SPIRAM, MEM_VIDEO);
+            ok = frames[i] && xQueueSend(free_frames, &i, 0) == pdTRUE;
+        }
+
+        if(!ok) {
+            Serial.println("error: failed to allocate video buffers");
+
+            close_file();
+
+            release_buffers();
+
+            return false;
+        }
+
+        if(mode == VIDEO_PAUSE_LVGL)
+            lv_timer_pause(lv_disp_get_default()->refr_timer);
+        else
+            set_flush_hook(redraw_overlay);
+
+        playing = true;
+        started = true;
+
+        int tasks = 0;
+
+        if(xTaskCreate(read_task, "video_read", 4096, nullptr, 4, nullptr) == pdPASS)
+            tasks++;
+
+        if(tasks == 1 && xTaskCreate(decode_task, "video_decode", 8192, nullptr, 4, nullptr) == pdPASS)
+            tasks++;
+
+        if(tasks == 2 && xTaskCreate(push_task, "video_push", 4096, nullptr, 5, nullptr) == pdPASS)
+            tasks++;
+
+        if(tasks < 3) {
+            Serial.println("error: failed to start video tasks");
+
+            shut_down(tasks);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void stop_video(void)
+    {
+        if(!started)
+            return;
+
+        shut_down(3);
+    }
+
+    bool is_video_playing(void)
+    {
+        return playing;
+    }
+
+    void get_video_stats(video_stats* stats_)
+    {
+        portENTER_CRITICAL(&stats_lock);
+        *stats_ = stats;
+        portEXIT_CRITICAL(&stats_lock);
+    }
+
+    static void read_task(void* arg)
+    {
+        uint32_t index = 0;
+
+        uint8_t slot;
+
+        while(receive(free_slots, &slot, &stats.read_stalls)) {
+            video_slot& s = slots[slot];
+
+            uint32_t size = 0;
+
+            if(read_sd(file, (uint8_t*) &size, sizeof(size)) != sizeof(size)) {
+                if(looping && index && hold_sd()) {
+                    file.seek(sizeof(video_header));
+
+                    release_sd();
+
+                    if(read_sd(file, (uint8_t*) &size, sizeof(size)) != sizeof(size))
+                        size = 0;
+                }
+
+                if(!size) {
+                    s.index = VIDEO_END;
+
+                    send(filled_slots, &slot);
+
+                    break;
+                }
+            }
+
+            if(size > COFFEE_VIDEO_SLOT_SIZE || read_sd(file, s.data, size) != size) {
+                Serial.printf("error: video frame %u is broken or larger than COFFEE_VIDEO_SLOT_SIZE\n", index);
+
+                s.index = VIDEO_END;
+
+                send(filled_slots, &slot);
+
+                break;
+            }
+
+            s.size = size;
+            s.index = index++;
+
+            count(&stats.frames_read);
+
+            if(!send(filled_slots, &slot))
+                break;
+        }
+
+        xSemaphoreGive(exited);
+        vTaskDelete(nullptr);
+    }
+
+    static void decode_task(void* arg)
+    {
+        // 이 LGFX_Sprite는 JPEG 복원에만 사용하며, 픽셀을 바이트 순서가 뒤바뀐 RGB565로 저장함
+        // this LGFX_Sprite is only used to decode JPEGs, and stores pixels as byte-swapped RGB565
+        static LGFX_Sprite canvas;
+
+        // 마지막으로 복원된 프레임 버퍼, 다음 RLE 프레임의 기준이 됨
+        // last decoded frame buffer, the reference of the next RLE frame
+        int ref = -1;
+
+        // 깨진 RLE 프레임 뒤의 차분 프레임들은 잃어버린 프레임을 기준으로 만들어졌으므로, 전체 프레임이 올 때까지 버림
+        // the delta frames after a broken RLE frame were encoded against the lost frame, so they are dropped until a full frame arrives
+        bool resync = false;
+
+        uint8_t slot;
+
+        while(receive(filled_slots, &slot, &stats.decode_stalls)) {
+            const video_slot& s = slots[slot];
+
+            if(s.index == VIDEO_END) {
+                video_frame end = { 0, 0, 0, VIDEO_END };
+
+                send(decoded_frames, &end);
+
+                break;
+            }
+
+            // 빈 버퍼는 반환된 순서대로 나오므로 ref와 겹치지 않음
+            // free buffers come out in the order they were returned, so this never is ref
+            uint8_t buffer;
+            if(!receive(free_frames, &buffer, &stats.decode_stalls))
+                break;
+
+            video_frame frame = { buffer, 0, (int16_t) (header.height - 1), s.index };
+
+            int64_t start = esp_timer_get_time();
+
+            bool ok;
+
+            // JPEG 프레임은 모두 전체 프레임
+            // every JPEG frame is a full frame
+            bool full = true;
+
+            if(header.codec == VIDEO_RLE)
+                ok = decode_rle(s.data, s.size, frames[buffer], ref < 0 || resync ? nullptr : frames[ref], &frame.y0, &frame.y1, &full);
+            else {
+                canvas.setBuffer(frames[buffer], header.width, header.height, lgfx::rgb565_2Byte);
+
+                ok = canvas.drawJpg(s.data, s.size, 0, 0);
+            }
+
+            count_max(&stats.max_decode_us, esp_timer_get_time() - start);
+
+            send(free_slots, &slot);
+
+            // 깨진 프레임은 표시하지 않음
+            // a broken frame is not shown
+            if(!ok) {
+                count(&stats.decode_errors);
+
+                resync = true;
+
+                send(free_frames, &buffer);
+
+                continue;
+            }
+
+            if(resync && !full) {
+                count(&stats.frames_dropped);
+
+                send(free_frames, &buffer);
+
+                continue;
+            }
+
+            resync = false;
+
+            ref = buffer;
+
+            count(&stats.frames_decoded);
+
+            if(!send(decoded_frames, &frame))
+                break;
+        }
+
+        xSemaphoreGive(exited);
+        vTaskDelete(nullptr);
+    }
+
+    static void push_task(void* arg)
+    {
+        uint32_t period_us = 1000000 / header.fps;
+
+        int64_t origin = 0;
+
+        // 건너뛴 프레임에서 바뀐 줄도 다음에 표시되는 프레임과 함께 전송함
+        // rows changed in skipped frames are pushed along with the next shown frame
+        int16_t dirty_y0 = INT16_MAX;
+        int16_t dirty_y1 = -1;
+
+        video_frame frame;
+
+        while(receive(decoded_frames, &frame, &stats.push_stalls)) {
+            if(frame.index == VIDEO_END)
+                break;
+
+            dirty_y0 = min(dirty_y0, frame.y0);
+            dirty_y1 = max(dirty_y1, frame.y1);
+
+            int64_t now = esp_timer_get_time();
+
+            if(!origin)
+                origin = now - (int64_t) frame.index * period_us;
+
+            int64_t deadline = origin + (int64_t) frame.index * period_us;
+
+            // 한 프레임 이상 늦었고 다음 프레임이 이미 준비되었다면 이 프레임은 건너뜀, 재생 끝 표시는 프레임이 아님
+            // skip this frame if it is more than a frame late and the next one is already decoded, the end marker is not a frame
+            video_frame next;
+
+            if(now > deadline + period_us && xQueuePeek(decoded_frames, &next, 0) == pdTRUE && next.index != VIDEO_END) {
+                count(&stats.frames_dropped);
+
+                send(free_frames, &frame.buffer);
+
+                continue;
+            }
+
+            if(now < deadline)
+                vTaskDelay(pdMS_TO_TICKS((deadline - now) / 1000));
+
+            wait_vsync(period_us / 1000 + 1);
+
+            int64_t start = esp_timer_get_time();
+
+            lock_lcd();
+
+            if(dirty_y0 <= dirty_y1)
+                push_rows(frame.buffer, dirty_y0, dirty_y1);
+
+            int previous = shown;
+            shown = frame.buffer;
+
+            unlock_lcd();
+
+            count_max(&stats.max_push_us, esp_timer_get_time() - start);
+
+            // 이전에 표시되던 버퍼는 redraw_overlay()에서 더 이상 읽지 않으므로 반환
+            // the previously shown buffer is no longer read by redraw_overlay(), so return it
+            if(previous >= 0) {
+                uint8_t buffer = previous;
+
+                send(free_frames, &buffer);
+            }
+
+            dirty_y0 = INT16_MAX;
+            dirty_y1 = -1;
+
+            count(&stats.frames_shown);
+        }
+
+        playing = false;
+
+        xSemaphoreGive(exited);
+        vTaskDelete(nullptr);
+    }
+
+    static bool decode_rle(const uint8_t* src, uint32_t size, uint16_t* dst, const uint16_t* ref, int16_t* y0, int16_t* y1, bool* full)
+    {
+        const uint8_t* end = src + size;
+
+        const uint32_t pixels = header.width * header.height;
+
+        uint32_t pos = 0;
+
+        uint32_t first = pixels;
+        uint32_t last = 0;
+
+        while(src + 2 <= end && pos < pixels) {
+            uint16_t op = src[0] | src[1] << 8;
+            src += 2;
+
+            uint32_t count = op & 0x3FFF;
+            if(pos + count > pixels)
+                return false;
+
+            switch(op >> 14) {
+            case VIDEO_RLE_SKIP:
+                if(count)
+                    *full = false;
+
+                if(ref && ref != dst)
+                    memcpy(dst + pos, ref + pos, count * sizeof(uint16_t));
+
+                pos += count;
+
+                continue;
+
+            case VIDEO_RLE_FILL: {
+                if(src + 2 > end)
+                    return false;
+
+                uint16_t color = src[0] | src[1] << 8;
+                src += 2;
+
+                for(uint32_t i = 0; i < count; i++)
+                    dst[pos + i] = color;
+
+                break;
+            }
+
+            case VIDEO_RLE_LITERAL:
+                if(src + count * 2 > end)
+                    return false;
+
+                memcpy(dst + pos, src, count * sizeof(uint16_t));
+                src += count * 2;
+
+                break;
+
+            default:
+                return false;
+            }
+
+            if(count) {
+                first = min(first, pos);
+                last = max(last, pos + count - 1);
+            }
+
+            pos += count;
+        }
+
+        if(pos < pixels)
+            *full = false;
+
+        // 명령어가 다루지 않은 나머지는 이전 프레임을 유지
+        // the rest not covered by any opcode keeps the previous frame
+        if(pos < pixels && ref && ref != dst)
+            memcpy(dst + pos, ref + pos, (pixels - pos) * sizeof(uint16_t));
+
+        if(first > last) {
+            *y0 = 0;
+            *y1 = -1;
+        } else {
+            *y0 = first / header.width;
+            *y1 = last / header.width;
+        }
+
+        return true;
+    }
+
+    static void push_rows(uint8_t buffer, int16_t y0, int16_t y1)
+    {
+        const uint16_t* rows = frames[buffer] + y0 * header.width;
+        int32_t height = y1 - y0 + 1;
+
+        if(header.codec == VIDEO_RLE)
+            lcd.pushImageDMA(video_x, video_y + y0, header.width, height, (const lgfx::rgb565_t*) rows);
+        else
+            lcd.pushImageDMA(video_x, video_y + y0, header.width, height, (const lgfx::swap565_t*) rows);
+
+        lcd.waitDMA();
+    }
+
+    static void redraw_overlay(const lv_area_t* area)
+    {
+        if(shown < 0)
+            return;
+
+        int32_t x1 = max<int32_t>(area->x1, video_x);
+        int32_t y1 = max<int32_t>(area->y1, video_y);
+        int32_t x2 = min<int32_t>(area->x2, video_x + header.width - 1);
+        int32_t y2 = min<int32_t>(area->y2, video_y + header.height - 1);
+
+        if(x1 > x2 || y1 > y2)
+            return;
+
+        lcd.setClipRect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
+        push_rows(shown, y1 - video_y, y2 - video_y);
+
+        lcd.clearClipRect();
+    }
+
+    static bool send(QueueHandle_t queue, const void* item)
+    {
+        while(!stopping)
+            if(xQueueSend(queue, item, pdMS_TO_TICKS(VIDEO_POLL_MS)) == pdTRUE)
+                return true;
+
+        return false;
+    }
+
+    static bool receive(QueueHandle_t queue, void* item, uint32_t* stalls)
+    {
+        if(xQueueReceive(queue, item, 0) == pdTRUE)
+            return true;
+
+        count(stalls);
+
+        while(!stopping)
+            if(xQueueReceive(queue, item, pdMS_TO_TICKS(VIDEO_POLL_MS)) == pdTRUE)
+                return true;
+
+        return false;
+    }
+
+    static void count(uint32_t* stat)
+    {
+        portENTER_CRITICAL(&stats_lock);
+        (*stat)++;
+        portEXIT_CRITICAL(&stats_lock);
+    }
+
+    static void count_max(uint32_t* stat, uint32_t value)
+    {
+        portENTER_CRITICAL(&stats_lock);
+
+        if(value > *stat)
+            *stat = value;
+
+        portEXIT_CRITICAL(&stats_lock);
+    }
+
+    static void shut_down(int tasks)
+    {
+        stopping = true;
+
+        for(int i = 0; i < tasks; i++)
+            xSemaphoreTake(exited, portMAX_DELAY);
+
+        lock_lcd();
+
+        set_flush_hook(nullptr);
+        shown = -1;
+
+        unlock_lcd();
+
+        close_file();
+
+        release_buffers();
+
+        if(mode == VIDEO_PAUSE_LVGL)
+            lv_timer_resume(lv_disp_get_default()->refr_timer);
+
+        // 마지막 프레임이 남은 자리를 lvgl이 다시 그리도록 함
+        // makes lvgl redraw where the last frame remains
+        lv_obj_invalidate(lv_scr_act());
+
+        playing = false;
+        started = false;
+    }
+
+    static void release_buffers(void)
+    {
+        for(video_slot& s: slots) {
+            mem_free(s.data);
+            s.data = nullptr;
+        }
+
+        for(uint16_t*& frame: frames) {
+            mem_free(frame);
+            frame = nullptr;
+        }
+
+        QueueHandle_t* queues[] = { &free_slots, &filled_slots, &free_frames, &decoded_frames };
+
+        for(QueueHandle_t* queue: queues)
+            if(*queue) {
+                vQueueDelete(*queue);
+                *queue = nullptr;
+            }
+
+        if(exited) {
+            vSemaphoreDelete(exited);
+            exited = nullptr;
+        }
+    }
+
+    static void close_file(void)
+    {
+        // 마운트되지 않았다면 파일은 이미 닫혀 있음
+        // the file is already closed if the card is not mounted
+        bool held = hold_sd();
+
+        untrack_sd(&file);
+
+        file.close();
+
+        if(held)
+            release_sd();
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef COFFEE_VIDEO_HPP
+#define COFFEE_VIDEO_HPP
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <Arduino.h>
+
+#include <FS.h>
+#include <SD.h>
+
+#include <lvgl.h>
+
+#include "def.h"
+#include "display.hpp"
+#include "sd.hpp"
+
+/**
+ * @def COFFEE_VIDEO_SLOTS
+ * 
+ * @brief SD 카드에서 읽어 들인 압축 프레임을 담아둘 버퍼 수입니다
+ * 
+ *        number of buffers holding compressed frames read from the SD card
+ */
+#define COFFEE_VIDEO_SLOTS 4
+
+/**
+ * @def COFFEE_VIDEO_SLOT_SIZE
+ * 
+ * @brief 압축 프레임 버퍼 하나의 크기입니다, 이보다 큰 프레임은 재생할 수 없습니다
+ * 
+ *        size of a single compressed frame buffer, larger frames cannot be played
+ */
+#define COFFEE_VIDEO_SLOT_SIZE (128 * 1024)
+
+/**
+ * @def COFFEE_VIDEO_FRAME_BUFFERS
+ * 
+ * @brief 복원된 프레임을 담아둘 버퍼 수입니다(최소 2)
+ * 
+ *        각각 영상 크기 * 2B의 PSRAM을 사용합니다
+ * 
+ *        number of buffers holding decoded frames(at least 2)
+ * 
+ *        each uses video size * 2B of PSRAM
+ */
+#define COFFEE_VIDEO_FRAME_BUFFERS 3
+
+namespace coffee
+{
+    enum video_codec {
+        // 프레임마다 JPEG 이미지 하나
+        // one JPEG image per frame
+        VIDEO_MJPEG,
+
+        // 이전 프레임에 대한 RGB565 차분 RLE
+        // RGB565 delta RLE against the previous frame
+        VIDEO_RLE
+    };
+
+    enum video_mode {
+        // 재생 중 lvgl 렌더링을 멈춤
+        // pauses lvgl rendering during playback
+        VIDEO_PAUSE_LVGL,
+
+        // lvgl 렌더링을 계속하고 그 위에 영상을 그림
+        // keeps lvgl rendering and draws the video over it
+        VIDEO_OVERLAY
+    };
+
+    /**
+     * @brief 영상 파일(.cfv) 헤더
+     * 
+     *        헤더 뒤에는 크기(4B, little endian)와 압축된 데이터로 이루어진 프레임들이 이어집니다
+     * 
+     *        RLE 데이터는 2B 명령어의 연속으로, 상위 2비트는 종류(0: 이전 프레임 유지, 1: 한 색으로 채움, 2: 픽셀 나열), 하위 14비트는 픽셀 수입니다
+     * 
+     *        채움 명령어 뒤에는 색 하나, 나열 명령어 뒤에는 픽셀 수만큼의 색이 RGB565(2B, little endian)로 이어집니다
+     * 
+     *        video file(.cfv) header
+     * 
+     *        the header is followed by frames made of a size(4B, little endian) and the compressed data
+     * 
+     *        RLE data is a sequence of 2B opcodes, the upper 2 bits are the kind(0: keep previous frame, 1: fill with a color, 2: literal pixels) and the lower 14 bits the pixel count
+     * 
+     *        a fill opcode is followed by one color, a literal opcode by as many colors as its pixel count, in RGB565(2B, little endian)
+     */
+    struct video_header {
+        char magic[4];
+
+        uint8_t codec;
+
+        uint8_t reserved;
+
+        uint16_t width;
+
+        uint16_t height;
+
+        uint16_t fps;
+
+        uint32_t frames;
+    };
+
+    /**
+     * @brief 영상 재생 통계
+     * 
+     *        video playback statistics
+     */
+    struct video_stats {
+        uint32_t frames_read;
+
+        uint32_t frames_decoded;
+
+        uint32_t frames_shown;
+
+        // 표시 시점을 한 프레임 이상 넘겨 건너뛰었거나, 깨진 RLE 프레임 뒤에서 전체 프레임을 기다리며 버린 프레임 수
+        // number of frames skipped for being more than a frame past their presentation time, or dropped after a broken RLE frame while waiting for a full frame
+        uint32_t frames_dropped;
+
+        uint32_t decode_errors;
+
+        // 각 단계가 앞 단계의 결과나 빈 버퍼를 기다린 횟수
+        // number of times each stage waited for the previous stage or for a free buffer
+        uint32_t read_stalls;
+
+        uint32_t decode_stalls;
+
+        uint32_t push_stalls;
+
+        uint32_t max_decode_us;
+
+        uint32_t max_push_us;
+    };
+
+    /**
+     * @brief SD 카드의 영상 파일을 재생합니다
+     * 
+     *        SD 카드 읽기, 복원, 화면 전송이 각각의 태스크에서 파이프라인으로 동작하며, 화면 전송은 vsync에 맞춰집니다
+     * 
+     *        lvgl을 호출하므로 lv_timer_handler()를 호출하는 태스크에서 호출하세요
+     * 
+     *        plays a video file from the SD card
+     * 
+     *        SD card reading, decoding and pushing to the screen run as a pipeline in their own tasks, pushes are aligned to vsync
+     * 
+     *        it calls into lvgl, so call it from the task calling lv_timer_handler()
+     * 
+     * @param path SD 카드 상의 영상 파일 경로(예: "/boot.cfv")
+     * 
+     *             path of the video file on the SD card(e.g. "/boot.cfv")
+     * 
+     * @param x 영상을 그릴 화면상의 X 좌표
+     * 
+     *          X coordinate on the screen to draw the video at
+     * 
+     * @param y 영상을 그릴 화면상의 Y 좌표
+     * 
+     *          Y coordinate on the screen to draw the video at
+     * 
+     * @param mode lvgl 렌더링을 멈출지, 그 위에 그릴지 여부
+     * 
+     *             whether to pause lvgl rendering or to draw over it
+     * 
+     * @param loop 끝까지 재생한 뒤 처음부터 다시 재생할지 여부
+     * 
+     *             whether to restart from the beginning after reaching the end
+     * 
+     * @return 재생 시작 성공 여부
+     * 
+     *         playback start success
+     */
+    bool play_video(const char* path, int32_t x, int32_t y, video_mode mode = VIDEO_PAUSE_LVGL, bool loop = false);
+
+    /**
+     * @brief 영상 재생을 멈추고 버퍼를 해제합니다, VIDEO_PAUSE_LVGL이었다면 lvgl 렌더링을 재개합니다
+     * 
+     *        lvgl을 호출하므로 lv_timer_handler()를 호출하는 태스크에서 호출하세요
+     * 
+     *        stops video playback and frees the buffers, resumes lvgl rendering if it was VIDEO_PAUSE_LVGL
+     * 
+     *        it calls into lvgl, so call it from the task calling lv_timer_handler()
+     */
+    void stop_video(void);
+
+    /**
+     * @brief 영상이 재생 중인지 확인합니다, 끝까지 재생된 뒤에도 stop_video()를 호출해야 합니다
+     * 
+     *        checks whether a video is playing, stop_video() must still be called after it reaches the end
+     */
+    bool is_video_playing(void);
+
+    /**
+     * @brief 영상 재생 통계를 가져옵니다
+     * 
+     *        gets the video playback statistics
+     */
+    void get_video_stats(video_stats* stats);
+}
+#endif
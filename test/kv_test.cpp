@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include "kv.hpp"
+
+// 리눅스 호스트에서 로컬 파일로 kv 저장소를 시험합니다
+// tests the kv store against a local file on a Linux host
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            printf("error: check failed at line %d: %s\n", __LINE__, #cond); \
+            return false; \
+        } \
+    } while(0)
+
+static const char* const path = "kv_test.kv";
+
+static const char* const tmp = "kv_test.tmp";
+
+static long file_size(void)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file)
+        return -1;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+
+    fclose(file);
+
+    return size;
+}
+
+static bool check_value(coffee::kv& store, const std::string& key, const std::string& expected)
+{
+    std::string value;
+
+    return store.get(key, &value) && value == expected;
+}
+
+static bool test_basic(void)
+{
+    coffee::kv store;
+    CHECK(store.open(path));
+
+    CHECK(store.put("a", "1"));
+    CHECK(store.put("b", "22"));
+    CHECK(store.remove("a"));
+
+    coffee::kv_batch batch;
+    batch.put("c", "333");
+    batch.put("b", "x");
+    CHECK(store.commit(batch));
+    CHECK(batch.empty());
+
+    CHECK(!store.contains("a"));
+    CHECK(check_value(store, "b", "x"));
+    CHECK(check_value(store, "c", "333"));
+
+    batch.put("", "empty key");
+    CHECK(!store.commit(batch));
+
+    return true;
+}
+
+static bool test_reopen(void)
+{
+    coffee::kv store;
+    CHECK(store.open(path));
+
+    coffee::kv_stats stats;
+    store.get_stats(&stats);
+
+    CHECK(stats.keys == 2);
+    CHECK(stats.discarded_bytes == 0 && stats.corrupt_bytes == 0);
+    CHECK(check_value(store, "b", "x"));
+    CHECK(check_value(store, "c", "333"));
+
+    return true;
+}
+
+static bool test_torn_tail(void)
+{
+    long size;
+
+    {
+        coffee::kv store;
+        CHECK(store.open(path));
+
+        size = file_size();
+
+        coffee::kv_batch batch;
+        batch.put("d", "torn");
+        batch.put("e", "torn");
+        CHECK(store.commit(batch));
+    }
+
+    // 마지막 묶음을 쓰던 중 전원이 끊긴 것처럼 커밋 레코드 일부를 잘라냄
+    // cuts off part of the commit record as if power was lost while writing the last batch
+    CHECK(truncate(path, file_size() - 5) == 0);
+
+    coffee::kv store;
+    CHECK(store.open(path));
+
+    coffee::kv_stats stats;
+    store.get_stats(&stats);
+
+    CHECK(stats.discarded_bytes > 0);
+    CHECK(file_size() == size);
+    CHECK(!store.contains("d") && !store.contains("e"));
+    CHECK(check_value(store, "c", "333"));
+
+    // 잘라낸 뒤에 덧붙인 묶음은 다음 마운트에서 보여야 함
+    // a batch appended after the cut must be seen at the next mount
+    CHECK(store.put("d", "4"));
+
+    store.close();
+
+    CHECK(store.open(path));
+    CHECK(check_value(store, "d", "4"));
+
+    return true;
+}
+
+static bool test_corrupt_middle(void)
+{
+    long offset;
+
+    {
+        coffee::kv store;
+        CHECK(store.open(path));
+
+        offset = file_size();
+
+        CHECK(store.put("f", "corrupted"));
+        CHECK(store.put("g", "kept"));
+        CHECK(store.put("b", "newer"));
+    }
+
+    // 중간 묶음의 값에서 한 바이트를 뒤집음
+    // flips a byte in the value of a batch in the middle
+    FILE* file = fopen(path, "r+b");
+    CHECK(file);
+
+    fseek(file, offset + 12 + 1 + 2, SEEK_SET);
+    int c = fgetc(file);
+
+    fseek(file, offset + 12 + 1 + 2, SEEK_SET);
+    fputc(c ^ 0x01, file);
+
+    fclose(file);
+
+    long size = file_size();
+
+    coffee::kv store;
+    CHECK(store.open(path));
+
+    coffee::kv_stats stats;
+    store.get_stats(&stats);
+
+    // 손상된 묶음만 건너뛰고 뒤의 커밋된 묶음들은 유지됨
+    // only the corrupt batch is skipped and the committed batches after it are kept
+    CHECK(stats.corrupt_bytes > 0 && stats.discarded_bytes == 0);
+    CHECK(file_size() == size);
+    CHECK(!store.contains("f"));
+    CHECK(check_value(store, "g", "kept"));
+    CHECK(check_value(store, "b", "newer"));
+    CHECK(check_value(store, "d", "4"));
+
+    return true;
+}
+
+static bool test_compaction(void)
+{
+    coffee::kv store;
+    CHECK(store.open(path));
+
+    for(int i = 0; i < 5000; i++)
+        CHECK(store.put("k" + std::to_string(i % 10), std::string(50, 'a' + i % 26)));
+
+    // 백그라운드 압축을 기다림
+    // waits for the background compaction
+    coffee::kv_stats stats;
+
+    for(int i = 0; i < 100; i++) {
+        store.get_stats(&stats);
+
+        if(stats.compactions)
+            break;
+
+        usleep(10000);
+    }
+
+    CHECK(stats.compactions > 0);
+    CHECK(check_value(store, "k3", std::string(50, 'a' + 4993 % 26)));
+
+    // 압축하는 동안 커밋된 값들도 압축된 파일에 남아야 함
+    // values committed while compacting must also remain in the compacted file
+    bool writer_ok = true;
+
+    std::thread writer([&store, &writer_ok] {
+        for(int i = 0; i < 500; i++)
+            writer_ok = store.put("w" + std::to_string(i % 20), std::to_string(i)) && writer_ok;
+
+        writer_ok = store.remove("k0") && writer_ok;
+    });
+
+    // 백그라운드 압축과 겹치면 false이므로 다시 시도함
+    // it is false when overlapping with the background compaction, so it is retried
+    bool compacted = false;
+
+    for(int i = 0; i < 100 && !compacted; i++)
+        compacted = store.compact();
+
+    writer.join();
+
+    CHECK(writer_ok);
+    CHECK(compacted);
+
+    CHECK(check_value(store, "c", "333"));
+    CHECK(check_value(store, "w19", "499"));
+    CHECK(!store.contains("k0"));
+
+    store.close();
+
+    CHECK(store.open(path));
+
+    store.get_stats(&stats);
+
+    CHECK(stats.discarded_bytes == 0 && stats.corrupt_bytes == 0);
+    CHECK(check_value(store, "k9", std::string(50, 'a' + 4999 % 26)));
+    CHECK(check_value(store, "w0", "480"));
+    CHECK(!store.contains("k0"));
+
+    return true;
+}
+
+static bool test_interrupted_swap(void)
+{
+    // 압축 중 원래 파일을 지운 뒤, 이름을 바꾸기 전에 전원이 끊긴 경우
+    // power lost after removing the original file during compaction, before renaming
+    CHECK(rename(path, tmp) == 0);
+
+    coffee::kv store;
+    CHECK(store.open(path));
+    CHECK(access(tmp, F_OK) != 0);
+    CHECK(check_value(store, "c", "333"));
+
+    return true;
+}
+
+int main(void)
+{
+    unlink(path);
+    unlink(tmp);
+
+    struct {
+        const char* name;
+
+        bool (*run)(void);
+    } tests[] = {
+        { "basic", test_basic },
+        { "reopen", test_reopen },
+        { "torn tail", test_torn_tail },
+        { "corrupt middle", test_corrupt_middle },
+        { "compaction", test_compaction },
+        { "interrupted swap", test_interrupted_swap }
+    };
+
+    int failed = 0;
+
+    for(const auto& test: tests) {
+        bool ok = test.run();
+
+        printf("%s: %s\n", test.name, ok ? "ok" : "failed");
+
+        failed += !ok;
+    }
+
+    unlink(path);
+    unlink(tmp);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+# PNG 프레임들을 coffee-driver 영상 파일(.cfv)로 만듭니다
+# builds a coffee-driver video file(.cfv) from PNG frames
+#
+# usage: encode_video.py [--codec rle|mjpeg] [--fps 30] [--quality 80] [--keyframe 30] out.cfv frame0.png frame1.png ...
+
+import argparse
+import io
+import struct
+import sys
+
+from PIL import Image
+
+CODEC_MJPEG = 0
+CODEC_RLE = 1
+
+RLE_SKIP = 0
+RLE_FILL = 1
+RLE_LITERAL = 2
+
+# 명령어 하나가 다룰 수 있는 최대 픽셀 수
+# maximum pixel count of a single opcode
+RLE_MAX = 0x3FFF
+
+# 이보다 짧은 같은 색 구간은 나열 명령어에 포함
+# runs of the same color shorter than this are folded into literal opcodes
+RLE_MIN_FILL = 3
+
+
+def to_rgb565(image):
+    pixels = image.convert("RGB").getdata()
+
+    return [(r >> 3) << 11 | (g >> 2) << 5 | b >> 3 for r, g, b in pixels]
+
+
+def op(kind, count):
+    return struct.pack("<H", kind << 14 | count)
+
+
+def encode_rle(frame, previous):
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:RLE_MAX]
+            del literal[:RLE_MAX]
+
+            out.extend(op(RLE_LITERAL, len(chunk)))
+            out.extend(struct.pack("<%dH" % len(chunk), *chunk))
+
+    pos = 0
+    while pos < len(frame):
+        # 이전 프레임과 같은 구간
+        # run equal to the previous frame
+        end = pos
+        if previous is not None:
+            while end < len(frame) and end - pos < RLE_MAX and frame[end] == previous[end]:
+                end += 1
+
+        if end > pos:
+            flush_literal()
+            out.extend(op(RLE_SKIP, end - pos))
+            pos = end
+
+            continue
+
+        # 한 색으로 이루어진 구간
+        # run of a single color
+        while end < len(frame) and end - pos < RLE_MAX and frame[end] == frame[pos]:
+            end += 1
+
+        if end - pos >= RLE_MIN_FILL:
+            flush_literal()
+            out.extend(op(RLE_FILL, end - pos))
+            out.extend(struct.pack("<H", frame[pos]))
+            pos = end
+        else:
+            literal.extend(frame[pos:end])
+            pos = end
+
+    flush_literal()
+
+    return bytes(out)
+
+
+def encode_mjpeg(image, quality):
+    out = io.BytesIO()
+    image.convert("RGB").save(out, "JPEG", quality=quality)
+
+    return out.getvalue()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="build a coffee-driver video file(.cfv) from PNG frames")
+    parser.add_argument("--codec", choices=["rle", "mjpeg"], default="rle")
+    parser.add_argument("--fps", type=int, default=30)
+    parser.add_argument("--quality", type=int, default=80, help="JPEG quality for mjpeg")
+    parser.add_argument("--keyframe", type=int, help="encode every Nth rle frame without the previous frame, 0 for only the first(default: fps)")
+    parser.add_argument("output")
+    parser.add_argument("frames", nargs="+")
+    args = parser.parse_args()
+
+    images = [Image.open(path) for path in args.frames]
+
+    width, height = images[0].size
+    for path, image in zip(args.frames, images):
+        if image.size != (width, height):
+            sys.exit("error: %s is not %dx%d" % (path, width, height))
+
+    codec = CODEC_RLE if args.codec == "rle" else CODEC_MJPEG
+
+    keyframe = args.fps if args.keyframe is None else args.keyframe
+
+    with open(args.output, "wb") as out:
+        out.write(b"CFV1" + struct.pack("<BBHHHI", codec, 0, width, height, args.fps, len(images)))
+
+        previous = None
+        largest = 0
+
+        for index, image in enumerate(images):
+            if codec == CODEC_RLE:
+                frame = to_rgb565(image)
+
+                # 첫 프레임은 반복 재생 시 마지막 프레임 뒤에 오므로 이전 프레임 없이 압축함
+                # the first frame follows the last one when looping, so it is encoded without a previous frame
+                #
+                # 깨진 프레임 뒤에 재생이 다시 맞춰지도록 keyframe마다 전체 프레임을 넣음
+                # a full frame is put every keyframe frames so playback can resync after a broken frame
+                if keyframe and index % keyframe == 0:
+                    previous = None
+
+                data = encode_rle(frame, previous)
+                previous = frame
+            else:
+                data = encode_mjpeg(image, args.quality)
+
+            out.write(struct.pack("<I", len(data)) + data)
+            largest = max(largest, len(data))
+
+    print("%d frames, largest %d bytes(must not exceed COFFEE_VIDEO_SLOT_SIZE)" % (len(images), largest))
+
+
+if __name__ == "__main__":
+    main()
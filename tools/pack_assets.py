@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# 디렉토리의 파일들을 에셋 파티션 이미지로 묶습니다
+# packs the files of a directory into an asset partition image
+#
+# usage: pack_assets.py [--size 0x1F0000] assets_dir assets.bin
+#
+# flash the image with: parttool.py write_partition --partition-name assets --input assets.bin
+
+import argparse
+import os
+import struct
+import sys
+
+# src/assets.hpp의 COFFEE_ASSET_NAME_MAX와 같아야 함
+# must match COFFEE_ASSET_NAME_MAX in src/assets.hpp
+NAME_MAX = 56
+
+HEADER = struct.Struct("<4sIII")
+ENTRY = struct.Struct("<%dsII" % NAME_MAX)
+
+# 파일 데이터 정렬 단위
+# alignment of file data
+ALIGN = 4
+
+
+def align(n):
+    return (n + ALIGN - 1) // ALIGN * ALIGN
+
+
+def collect(root):
+    files = []
+
+    for dirpath, _, filenames in os.walk(root):
+        for filename in filenames:
+            path = os.path.join(dirpath, filename)
+            name = os.path.relpath(path, root).replace(os.sep, "/")
+
+            if len(name.encode()) >= NAME_MAX:
+                sys.exit("error: path is longer than %d bytes(%s)" % (NAME_MAX - 1, name))
+
+            files.append((name.encode(), path))
+
+    # 장치에서 이진 탐색할 수 있도록 strcmp 순서로 정렬
+    # sorted in strcmp order so the device can binary search
+    files.sort()
+
+    return files
+
+
+def main():
+    parser = argparse.ArgumentParser(description="pack the files of a directory into an asset partition image")
+    parser.add_argument("--size", type=lambda s: int(s, 0), help="partition size, fails if the image does not fit")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    files = collect(args.input)
+
+    offset = align(HEADER.size + ENTRY.size * len(files))
+
+    entries = bytearray()
+    data = bytearray()
+
+    for name, path in files:
+        with open(path, "rb") as f:
+            content = f.read()
+
+        entries += ENTRY.pack(name, offset + len(data), len(content))
+
+        data += content
+        data += b"\0" * (align(len(content)) - len(content))
+
+    size = offset + len(data)
+
+    if args.size is not None and size > args.size:
+        sys.exit("error: image(%d bytes) does not fit the partition(%d bytes)" % (size, args.size))
+
+    with open(args.output, "wb") as out:
+        out.write(HEADER.pack(b"CFAS", len(files), size, 0))
+        out.write(entries)
+        out.write(b"\0" * (offset - HEADER.size - len(entries)))
+        out.write(data)
+
+    print("%d files, %d bytes" % (len(files), size))
+
+
+if __name__ == "__main__":
+    main()